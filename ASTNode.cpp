@@ -1,14 +1,64 @@
 #include "ASTNode.h"
-#include <sstream>
 using namespace std;
 
-string ASTNode::repr() const {
-    ostringstream oss;
-    oss << "ASTNode(" << type << ", " << value << ", [";
-    for (size_t i = 0; i < children.size(); ++i) {
-        if (children[i]) oss << children[i]->repr();
-        if (i + 1 < children.size()) oss << ", ";
+const char* node_kind_name(NodeKind kind) {
+    static const char* const names[] = {
+        "PROGRAM", "FUNCTION", "DECL", "ASSIGN", "BINOP", "RELOP", "NUMBER", "ID",
+        "WHILE", "FOR", "IF", "BODY", "THEN", "ELSE", "RETURN",
+        "ARRAY_DECL", "INDEX", "INDEX_ASSIGN"
+    };
+    return names[static_cast<int>(kind)];
+}
+
+NodeId AST::add(NodeKind kind, uint32_t value, initializer_list<NodeId> kids) {
+    uint32_t first = static_cast<uint32_t>(child_ids.size());
+    child_ids.insert(child_ids.end(), kids.begin(), kids.end());
+    nodes.push_back(ASTNode{kind, value, first, static_cast<uint32_t>(kids.size())});
+    return static_cast<NodeId>(nodes.size() - 1);
+}
+
+NodeId AST::add(NodeKind kind, uint32_t value, vector<NodeId>& stack, size_t mark) {
+    uint32_t first = static_cast<uint32_t>(child_ids.size());
+    child_ids.insert(child_ids.end(), stack.begin() + mark, stack.end());
+    nodes.push_back(ASTNode{kind, value, first, static_cast<uint32_t>(stack.size() - mark)});
+    stack.resize(mark);
+    return static_cast<NodeId>(nodes.size() - 1);
+}
+
+string AST::repr() const {
+    string out;
+    if (!nodes.empty()) repr(root, out);
+    return out;
+}
+
+void AST::repr(NodeId id, string& out) const {
+    out += "ASTNode(";
+    out += node_kind_name(nodes[id].kind);
+    out += ", ";
+    out += text(id);
+    out += ", [";
+    ChildRange kids = children(id);
+    for (size_t i = 0; i < kids.size(); ++i) {
+        repr(kids[i], out);
+        if (i + 1 < kids.size()) out += ", ";
     }
-    oss << "] )";
-    return oss.str();
-} 
\ No newline at end of file
+    out += "] )";
+}
+
+void AST::reserve(size_t node_count) {
+    nodes.reserve(node_count);
+    child_ids.reserve(node_count);
+}
+
+size_t AST::memory_bytes() const {
+    return nodes.capacity() * sizeof(ASTNode) + child_ids.capacity() * sizeof(NodeId)
+        + names.memory_bytes() + literals.memory_bytes();
+}
+
+void AST::clear() {
+    vector<ASTNode>().swap(nodes);
+    vector<NodeId>().swap(child_ids);
+    names.clear();
+    literals.clear();
+    root = 0;
+}
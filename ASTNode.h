@@ -1,17 +1,86 @@
 #ifndef ASTNODE_H
 #define ASTNODE_H
+#include <cstdint>
+#include <initializer_list>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <memory>
+#include "StringInterner.h"
 
-class ASTNode {
+enum class NodeKind : unsigned char {
+    PROGRAM, FUNCTION, DECL, ASSIGN, BINOP, RELOP, NUMBER, ID,
+    WHILE, FOR, IF, BODY, THEN, ELSE, RETURN,
+    ARRAY_DECL, INDEX, INDEX_ASSIGN,
+    COUNT
+};
+
+const char* node_kind_name(NodeKind kind);
+
+typedef uint32_t NodeId;
+
+// value is an identifier id (FUNCTION, DECL, ASSIGN, ID and the array
+// kinds), a literal id (NUMBER, BINOP, RELOP operator) or AST::NO_VALUE; the
+// children are child_count consecutive entries of the AST's child array.
+// ARRAY_DECL has the length as its NUMBER child, INDEX the index expression,
+// and INDEX_ASSIGN the index and then the value stored.
+struct ASTNode {
+    NodeKind kind;
+    uint32_t value;
+    uint32_t first_child;
+    uint32_t child_count;
+};
+
+// A whole parse tree: nodes and child lists live in append-only arrays and
+// identifiers in an interner, so the tree is freed in one shot by clear().
+class AST {
 public:
-    std::string type;
-    std::string value;
-    std::vector<std::shared_ptr<ASTNode>> children;
-    ASTNode(const std::string& type_, const std::string& value_ = "", const std::vector<std::shared_ptr<ASTNode>>& children_ = {})
-        : type(type_), value(value_), children(children_) {}
+    static constexpr uint32_t NO_VALUE = UINT32_MAX;
+
+    struct ChildRange {
+        const NodeId* first;
+        const NodeId* last;
+        const NodeId* begin() const { return first; }
+        const NodeId* end() const { return last; }
+        size_t size() const { return last - first; }
+        bool empty() const { return first == last; }
+        NodeId operator[](size_t i) const { return first[i]; }
+    };
+
+    NodeId root = 0;
+    StringInterner names;    // identifiers, so their ids are dense symbol ids
+    StringInterner literals; // numbers and operators
+
+    NodeId add(NodeKind kind, uint32_t value = NO_VALUE, std::initializer_list<NodeId> kids = {});
+    // Adopts stack[mark..] as the node's children and pops them off the stack.
+    NodeId add(NodeKind kind, uint32_t value, std::vector<NodeId>& stack, size_t mark);
+
+    const ASTNode& node(NodeId id) const { return nodes[id]; }
+    ChildRange children(NodeId id) const {
+        const NodeId* first = child_ids.data() + nodes[id].first_child;
+        return ChildRange{first, first + nodes[id].child_count};
+    }
+    static bool has_identifier(NodeKind kind) {
+        return kind == NodeKind::FUNCTION || kind == NodeKind::DECL || kind == NodeKind::ASSIGN || kind == NodeKind::ID
+            || kind == NodeKind::ARRAY_DECL || kind == NodeKind::INDEX || kind == NodeKind::INDEX_ASSIGN;
+    }
+    std::string_view text(NodeId id) const {
+        const ASTNode& n = nodes[id];
+        if (n.value == NO_VALUE) return std::string_view();
+        return has_identifier(n.kind) ? names.str(n.value) : literals.str(n.value);
+    }
+
     std::string repr() const;
+    void reserve(size_t node_count);
+    size_t node_count() const { return nodes.size(); }
+    size_t memory_bytes() const;
+    void clear();
+
+private:
+    std::vector<ASTNode> nodes;
+    std::vector<NodeId> child_ids;
+    friend std::string encode_ast(const AST& ast);
+    friend void decode_ast(std::string_view image, AST& ast);
+    void repr(NodeId id, std::string& out) const;
 };
 
-#endif // ASTNODE_H 
\ No newline at end of file
+#endif // ASTNODE_H
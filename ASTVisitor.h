@@ -0,0 +1,67 @@
+#ifndef ASTVISITOR_H
+#define ASTVISITOR_H
+#include "ASTNode.h"
+
+// CRTP base for passes over an AST. visit() dispatches on the node kind with a
+// single switch to Derived::visit_<kind>; every handler a pass does not define
+// falls back to the default below, which visits the children in order.
+// Derived classes that keep their handlers private must befriend this base.
+template <typename Derived, typename Result = void>
+class ASTVisitor {
+public:
+    explicit ASTVisitor(const AST& ast_) : ast(ast_) {}
+
+protected:
+    const AST& ast;
+
+    Result visit(NodeId id) {
+        Derived& self = static_cast<Derived&>(*this);
+        switch (ast.node(id).kind) {
+            case NodeKind::PROGRAM:  return self.visit_program(id);
+            case NodeKind::FUNCTION: return self.visit_function(id);
+            case NodeKind::DECL:     return self.visit_decl(id);
+            case NodeKind::ASSIGN:   return self.visit_assign(id);
+            case NodeKind::BINOP:    return self.visit_binop(id);
+            case NodeKind::RELOP:    return self.visit_relop(id);
+            case NodeKind::NUMBER:   return self.visit_number(id);
+            case NodeKind::ID:       return self.visit_id(id);
+            case NodeKind::WHILE:    return self.visit_while(id);
+            case NodeKind::FOR:      return self.visit_for(id);
+            case NodeKind::IF:       return self.visit_if(id);
+            case NodeKind::BODY:     return self.visit_body(id);
+            case NodeKind::THEN:     return self.visit_then(id);
+            case NodeKind::ELSE:     return self.visit_else(id);
+            case NodeKind::RETURN:   return self.visit_return(id);
+            case NodeKind::ARRAY_DECL:   return self.visit_array_decl(id);
+            case NodeKind::INDEX:        return self.visit_index(id);
+            case NodeKind::INDEX_ASSIGN: return self.visit_index_assign(id);
+            default:                 return Result();
+        }
+    }
+
+    Result visit_children(NodeId id) {
+        for (NodeId child : ast.children(id)) visit(child);
+        return Result();
+    }
+
+    Result visit_program(NodeId id)  { return static_cast<Derived&>(*this).visit_children(id); }
+    Result visit_function(NodeId id) { return static_cast<Derived&>(*this).visit_children(id); }
+    Result visit_decl(NodeId id)     { return static_cast<Derived&>(*this).visit_children(id); }
+    Result visit_assign(NodeId id)   { return static_cast<Derived&>(*this).visit_children(id); }
+    Result visit_binop(NodeId id)    { return static_cast<Derived&>(*this).visit_children(id); }
+    Result visit_relop(NodeId id)    { return static_cast<Derived&>(*this).visit_children(id); }
+    Result visit_number(NodeId)      { return Result(); }
+    Result visit_id(NodeId)          { return Result(); }
+    Result visit_while(NodeId id)    { return static_cast<Derived&>(*this).visit_children(id); }
+    Result visit_for(NodeId id)      { return static_cast<Derived&>(*this).visit_children(id); }
+    Result visit_if(NodeId id)       { return static_cast<Derived&>(*this).visit_children(id); }
+    Result visit_body(NodeId id)     { return static_cast<Derived&>(*this).visit_children(id); }
+    Result visit_then(NodeId id)     { return static_cast<Derived&>(*this).visit_children(id); }
+    Result visit_else(NodeId id)     { return static_cast<Derived&>(*this).visit_children(id); }
+    Result visit_return(NodeId id)   { return static_cast<Derived&>(*this).visit_children(id); }
+    Result visit_array_decl(NodeId)  { return Result(); }
+    Result visit_index(NodeId id)    { return static_cast<Derived&>(*this).visit_children(id); }
+    Result visit_index_assign(NodeId id) { return static_cast<Derived&>(*this).visit_children(id); }
+};
+
+#endif // ASTVISITOR_H
@@ -0,0 +1,48 @@
+#ifndef ARENA_H
+#define ARENA_H
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Bump allocator: memory is carved from large blocks and only released all at
+// once by reset() or destruction. Nothing allocated from it is destructed.
+class Arena {
+public:
+    explicit Arena(size_t block_size = 64 * 1024) : block_size(block_size), ptr(nullptr), left(0), total(0) {}
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+        size_t pad = (align - reinterpret_cast<size_t>(ptr) % align) % align;
+        if (pad + size > left) {
+            size_t n = size + align > block_size ? size + align : block_size;
+            blocks.emplace_back(new char[n]);
+            total += n;
+            ptr = blocks.back().get();
+            left = n;
+            pad = (align - reinterpret_cast<size_t>(ptr) % align) % align;
+        }
+        void* p = ptr + pad;
+        ptr += pad + size;
+        left -= pad + size;
+        return p;
+    }
+
+    void reset() {
+        blocks.clear();
+        ptr = nullptr;
+        left = 0;
+        total = 0;
+    }
+
+    size_t bytes_reserved() const { return total; }
+
+private:
+    size_t block_size;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* ptr;
+    size_t left;
+    size_t total;
+};
+
+#endif // ARENA_H
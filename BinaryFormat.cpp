@@ -0,0 +1,391 @@
+#include "BinaryFormat.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+#include "SourceBuffer.h"
+#include "SymbolTable.h"
+using namespace std;
+
+namespace {
+
+const char AST_MAGIC[8] = {'C', 'D', 'A', 'S', 'T', 0, 0, 0};
+const char TAC_MAGIC[8] = {'C', 'D', 'T', 'A', 'C', 0, 0, 0};
+
+const size_t NODE_BYTES = 13;     // kind, value, first child, child count
+const size_t INSTR_BYTES = 20;    // op, three operands of kind and value, label
+
+class Writer {
+public:
+    explicit Writer(const char magic[8]) {
+        out.append(magic, 8);
+        u32(BINARY_FORMAT_VERSION);
+    }
+    void u8(uint8_t v) { out += static_cast<char>(v); }
+    void u32(uint32_t v) {
+        for (int shift = 0; shift < 32; shift += 8) out += static_cast<char>(v >> shift);
+    }
+    void i32(int32_t v) { u32(static_cast<uint32_t>(v)); }
+    void str(string_view s) {
+        u32(static_cast<uint32_t>(s.size()));
+        out.append(s.data(), s.size());
+    }
+    string out;
+};
+
+// Reads an image front to back; every read is bounds-checked, so a damaged
+// file ends in a runtime_error rather than in a read past the mapping.
+class Reader {
+public:
+    Reader(string_view image, const char magic[8], const char* what) : p(image.data()), end(p + image.size()), what(what) {
+        if (image.size() < 8 || memcmp(p, magic, 8) != 0) throw runtime_error(string("Not a saved ") + what);
+        p += 8;
+        uint32_t version = u32();
+        if (version != BINARY_FORMAT_VERSION) {
+            throw runtime_error(string(what) + " has format version " + to_string(version) + ", expected "
+                                + to_string(BINARY_FORMAT_VERSION));
+        }
+    }
+    uint8_t u8() {
+        need(1);
+        return static_cast<uint8_t>(*p++);
+    }
+    uint32_t u32() {
+        need(4);
+        uint32_t v = 0;
+        for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(static_cast<uint8_t>(p[i])) << (8 * i);
+        p += 4;
+        return v;
+    }
+    int32_t i32() { return static_cast<int32_t>(u32()); }
+    string_view str() {
+        uint32_t n = u32();
+        need(n);
+        string_view s(p, n);
+        p += n;
+        return s;
+    }
+    // A record count, checked against the bytes left before anything is reserved for it.
+    uint32_t count(size_t record_bytes) {
+        uint32_t n = u32();
+        need(static_cast<uint64_t>(n) * record_bytes);
+        return n;
+    }
+    void finish() const {
+        if (p != end) fail("trailing bytes");
+    }
+    [[noreturn]] void fail(const string& why) const { throw runtime_error("Corrupt " + string(what) + ": " + why); }
+
+private:
+    const char* p;
+    const char* end;
+    const char* what;
+
+    void need(uint64_t n) const {
+        if (n > static_cast<uint64_t>(end - p)) throw runtime_error("Truncated " + string(what));
+    }
+};
+
+void write_strings(Writer& w, const StringInterner& strings) {
+    w.u32(static_cast<uint32_t>(strings.size()));
+    for (size_t i = 0; i < strings.size(); ++i) w.str(strings.str(i));
+}
+
+// Interning in file order hands out the same ids the strings were saved with.
+void read_strings(Reader& r, StringInterner& strings) {
+    uint32_t n = r.count(4);
+    for (uint32_t i = 0; i < n; ++i) {
+        if (strings.intern(r.str()) != i) r.fail("duplicate string");
+    }
+}
+
+void write_operand(Writer& w, const Operand& o) {
+    w.u8(o.kind);
+    w.i32(o.value);
+}
+
+Operand read_operand(Reader& r, const TACFunction& f) {
+    uint8_t kind = r.u8();
+    int32_t value = r.i32();
+    if (kind > Operand::CONST) r.fail("bad operand kind");
+    if (kind == Operand::VAR && (value < 0 || static_cast<size_t>(value) >= f.vars.size())) r.fail("variable out of range");
+    if (kind == Operand::TEMP && (value < 0 || value > f.temp_count)) r.fail("temporary out of range");
+    return Operand{static_cast<Operand::Kind>(kind), value};
+}
+
+bool is_expr(NodeKind k) {
+    return k == NodeKind::BINOP || k == NodeKind::NUMBER || k == NodeKind::ID || k == NodeKind::INDEX;
+}
+bool is_statement(NodeKind k) {
+    return k == NodeKind::DECL || k == NodeKind::ASSIGN || k == NodeKind::WHILE || k == NodeKind::FOR
+        || k == NodeKind::IF || k == NodeKind::RETURN || k == NodeKind::ARRAY_DECL || k == NodeKind::INDEX_ASSIGN;
+}
+
+// Whether a node has the value and children the parser gives its kind, so the
+// later stages can walk a loaded tree as they would a parsed one.
+bool well_formed(const AST& ast, NodeId id) {
+    const ASTNode& n = ast.node(id);
+    AST::ChildRange kids = ast.children(id);
+    auto kind = [&](size_t i) { return ast.node(kids[i]).kind; };
+    auto all = [&](bool (*pred)(NodeKind)) {
+        for (size_t i = 0; i < kids.size(); ++i) {
+            if (!pred(kind(i))) return false;
+        }
+        return true;
+    };
+    auto is_cond = [&](size_t i) { return is_expr(kind(i)) || kind(i) == NodeKind::RELOP; };
+    bool has_value = n.value != AST::NO_VALUE;
+    string_view text = ast.text(id);
+    switch (n.kind) {
+        case NodeKind::PROGRAM:
+            return !has_value && (all(is_statement) || all([](NodeKind k) { return k == NodeKind::FUNCTION; }));
+        case NodeKind::FUNCTION: return has_value && all(is_statement);
+        case NodeKind::DECL:     return has_value && kids.size() <= 1 && all(is_expr);
+        case NodeKind::ASSIGN:   return has_value && kids.size() == 1 && all(is_expr);
+        case NodeKind::BINOP:
+            return (text == "+" || text == "-" || text == "*" || text == "/") && kids.size() == 2 && all(is_expr);
+        case NodeKind::RELOP:
+            return (text == "LT" || text == "GT" || text == "LE" || text == "GE" || text == "EQ" || text == "NE")
+                && kids.size() == 2 && all(is_expr);
+        case NodeKind::NUMBER:
+        case NodeKind::ID:       return has_value && kids.empty();
+        case NodeKind::WHILE:    return !has_value && kids.size() == 2 && is_cond(0) && kind(1) == NodeKind::BODY;
+        case NodeKind::FOR:      return !has_value && kids.size() == 2 && is_statement(kind(0)) && kind(1) == NodeKind::WHILE;
+        case NodeKind::IF:
+            return !has_value && kids.size() == 3 && is_cond(0) && kind(1) == NodeKind::THEN && kind(2) == NodeKind::ELSE;
+        case NodeKind::RETURN:   return !has_value && kids.size() == 1 && all(is_expr);
+        case NodeKind::ARRAY_DECL:   return has_value && kids.size() == 1 && kind(0) == NodeKind::NUMBER;
+        case NodeKind::INDEX:        return has_value && kids.size() == 1 && all(is_expr);
+        case NodeKind::INDEX_ASSIGN: return has_value && kids.size() == 2 && all(is_expr);
+        default:                 return !has_value && all(is_statement); // BODY, THEN, ELSE
+    }
+}
+
+// The operands each op uses must be present and the rest absent, as the
+// generator and the optimizer leave them, and vectors must be temporaries.
+bool well_formed(const TACInstr& in) {
+    bool dst = in.dst.is_name(), a = in.a.kind != Operand::NONE, b = in.b.kind != Operand::NONE;
+    bool vdst = in.dst.kind == Operand::TEMP, va = in.a.kind == Operand::TEMP, vb = in.b.kind == Operand::TEMP;
+    switch (in.op) {
+        case TACOp::COPY:
+        case TACOp::LOAD:     return dst && a && !b;
+        case TACOp::STORE:    return !in.has_dst() && a && b;
+        case TACOp::VLOAD:
+        case TACOp::VSPLAT:   return vdst && a && !b;
+        case TACOp::VSTORE:   return !in.has_dst() && a && vb;
+        case TACOp::VADD:
+        case TACOp::VSUB:
+        case TACOp::VMUL:     return vdst && va && vb;
+        case TACOp::VSUM:     return dst && va && !b;
+        case TACOp::LABEL:
+        case TACOp::GOTO:     return !in.has_dst() && !a && !b;
+        case TACOp::IF_FALSE:
+        case TACOp::RETURN:   return !in.has_dst() && a && !b;
+        default:              return dst && a && b;
+    }
+}
+
+void save(const string& image, const string& path) {
+    ofstream file(path, ios::binary);
+    if (!file.write(image.data(), image.size()) || !file.flush()) throw runtime_error("Cannot write file: " + path);
+}
+
+// The largest temporary and label a function mentions. Images store these
+// rather than the counters the function was built with, so counts read back
+// are bounded by the code that follows them.
+pair<int32_t, int32_t> used_counts(const TACFunction& f) {
+    int32_t temps = 0, labels = 0;
+    for (const auto& in : f.code) {
+        for (const Operand* o : {&in.dst, &in.a, &in.b}) {
+            if (o->kind == Operand::TEMP) temps = max(temps, o->value);
+        }
+        if (is_control_or_label(in.op) && in.op != TACOp::RETURN) labels = max(labels, in.label);
+    }
+    for (int32_t label : f.unrolled) labels = max(labels, label);
+    for (int32_t label : f.vectorized) labels = max(labels, label);
+    return {temps, labels};
+}
+
+} // namespace
+
+string encode_ast(const AST& ast) {
+    Writer w(AST_MAGIC);
+    write_strings(w, ast.names);
+    write_strings(w, ast.literals);
+    w.u32(ast.root);
+    w.u32(static_cast<uint32_t>(ast.nodes.size()));
+    for (const auto& n : ast.nodes) {
+        w.u8(static_cast<uint8_t>(n.kind));
+        w.u32(n.value);
+        w.u32(n.first_child);
+        w.u32(n.child_count);
+    }
+    w.u32(static_cast<uint32_t>(ast.child_ids.size()));
+    for (NodeId id : ast.child_ids) w.u32(id);
+    return move(w.out);
+}
+
+// The parser only adopts nodes that already exist, so every child has a
+// smaller id than its parent; insisting on that keeps a damaged image from
+// turning the tree into a cycle.
+void decode_ast(string_view image, AST& ast) {
+    Reader r(image, AST_MAGIC, "AST image");
+    ast.clear();
+    read_strings(r, ast.names);
+    read_strings(r, ast.literals);
+    ast.root = r.u32();
+    uint32_t node_count = r.count(NODE_BYTES);
+    ast.nodes.resize(node_count);
+    for (auto& n : ast.nodes) {
+        uint8_t kind = r.u8();
+        if (kind >= static_cast<uint8_t>(NodeKind::COUNT)) r.fail("bad node kind");
+        n.kind = static_cast<NodeKind>(kind);
+        n.value = r.u32();
+        n.first_child = r.u32();
+        n.child_count = r.u32();
+        size_t values = AST::has_identifier(n.kind) ? ast.names.size() : ast.literals.size();
+        if (n.value != AST::NO_VALUE && n.value >= values) r.fail("value out of range");
+    }
+    uint32_t child_count = r.count(4);
+    ast.child_ids.resize(child_count);
+    for (auto& id : ast.child_ids) id = r.u32();
+    r.finish();
+
+    if (ast.root >= node_count) r.fail("root out of range");
+    for (NodeId id = 0; id < node_count; ++id) {
+        const ASTNode& n = ast.nodes[id];
+        if (static_cast<uint64_t>(n.first_child) + n.child_count > child_count) r.fail("child list out of range");
+        for (NodeId child : ast.children(id)) {
+            if (child >= id) r.fail("child does not precede its parent");
+        }
+        if (!well_formed(ast, id)) r.fail(string("malformed ") + node_kind_name(n.kind) + " node");
+    }
+    NodeKind root = ast.node(ast.root).kind;
+    if (root != NodeKind::PROGRAM && root != NodeKind::FUNCTION) r.fail("root is not a program");
+}
+
+string encode_tac(const TACProgram& program) {
+    Writer w(TAC_MAGIC);
+    w.u32(static_cast<uint32_t>(program.functions.size()));
+    for (const auto& f : program.functions) {
+        w.str(f.name);
+        w.u8(f.has_header);
+        auto [temps, labels] = used_counts(f);
+        w.i32(temps);
+        w.i32(labels);
+        w.u32(static_cast<uint32_t>(f.vars.size()));
+        for (const auto& v : f.vars) w.str(v);
+        w.u32(static_cast<uint32_t>(f.arrays.size()));
+        for (const auto& a : f.arrays) {
+            w.str(a.name);
+            w.i32(a.length);
+        }
+        w.i32(f.vector_width);
+        w.u32(static_cast<uint32_t>(f.code.size()));
+        for (const auto& in : f.code) {
+            w.u8(static_cast<uint8_t>(in.op));
+            write_operand(w, in.dst);
+            write_operand(w, in.a);
+            write_operand(w, in.b);
+            w.i32(in.label);
+        }
+        w.u32(static_cast<uint32_t>(f.unrolled.size()));
+        for (int32_t label : f.unrolled) w.i32(label);
+        w.u32(static_cast<uint32_t>(f.vectorized.size()));
+        for (int32_t label : f.vectorized) w.i32(label);
+    }
+    return move(w.out);
+}
+
+TACProgram decode_tac(string_view image) {
+    Reader r(image, TAC_MAGIC, "TAC image");
+    TACProgram program;
+    program.functions.resize(r.count(4 + 1 + 4 + 4 + 4 + 4 + 4 + 4 + 4 + 4));
+    for (auto& f : program.functions) {
+        f.name = string(r.str());
+        f.has_header = r.u8() != 0;
+        f.temp_count = r.i32();
+        f.label_count = r.i32();
+        f.vars.resize(r.count(4));
+        for (auto& v : f.vars) v = string(r.str());
+        f.arrays.resize(r.count(4 + 4));
+        for (auto& a : f.arrays) {
+            a.name = string(r.str());
+            a.length = r.i32();
+            if (a.length < 1 || a.length > MAX_ARRAY_LENGTH) r.fail("bad array length");
+        }
+        f.vector_width = r.i32();
+        if (f.vector_width < 1 || f.vector_width > MAX_VECTOR_WIDTH) r.fail("bad vector width");
+        f.code.resize(r.count(INSTR_BYTES));
+        for (auto& in : f.code) {
+            uint8_t op = r.u8();
+            if (op >= static_cast<uint8_t>(TACOp::COUNT)) r.fail("bad opcode");
+            in.op = static_cast<TACOp>(op);
+            in.dst = read_operand(r, f);
+            in.a = read_operand(r, f);
+            in.b = read_operand(r, f);
+            in.label = r.i32();
+            if (!well_formed(in)) r.fail("malformed instruction");
+            if (is_control_or_label(in.op) && in.op != TACOp::RETURN && (in.label < 0 || in.label > f.label_count)) {
+                r.fail("label out of range");
+            }
+            if (is_memory(in.op) && (in.label < 0 || static_cast<size_t>(in.label) >= f.arrays.size())) {
+                r.fail("array out of range");
+            }
+        }
+        f.unrolled.resize(r.count(4));
+        for (auto& label : f.unrolled) label = r.i32();
+        f.vectorized.resize(r.count(4));
+        for (auto& label : f.vectorized) label = r.i32();
+        // Every later stage sizes arrays by the counts, so they may not
+        // exceed what the function uses.
+        auto [temps, labels] = used_counts(f);
+        if (f.temp_count != temps) r.fail("temporary count out of range");
+        if (f.label_count != labels) r.fail("label count out of range");
+        // A temporary holds vectors or scalars, never both.
+        vector<char> is_vector_temp(static_cast<size_t>(max(f.temp_count, 0)) + 1, 0);
+        for (const auto& in : f.code) {
+            unsigned vectors = vector_operands(in.op);
+            if (vectors & 1) is_vector_temp[in.dst.value] = 1;
+            if (vectors & 2) is_vector_temp[in.a.value] = 1;
+            if (vectors & 4) is_vector_temp[in.b.value] = 1;
+        }
+        for (const auto& in : f.code) {
+            unsigned vectors = vector_operands(in.op);
+            const Operand* operands[] = {&in.dst, &in.a, &in.b};
+            for (unsigned k = 0; k < 3; ++k) {
+                const Operand& o = *operands[k];
+                bool as_vector = (vectors >> k) & 1;
+                if (o.kind == Operand::TEMP && is_vector_temp[o.value] != as_vector) r.fail("temporary used as vector and scalar");
+            }
+        }
+        vector<char> defined(static_cast<size_t>(max(f.label_count, 0)) + 1, 0);
+        for (const auto& in : f.code) {
+            if (in.op == TACOp::LABEL && defined[in.label]++) r.fail("label defined twice");
+        }
+        for (const auto& in : f.code) {
+            if ((in.op == TACOp::GOTO || in.op == TACOp::IF_FALSE) && !defined[in.label]) r.fail("jump to undefined label");
+        }
+    }
+    r.finish();
+    return program;
+}
+
+void save_ast(const AST& ast, const string& path) {
+    save(encode_ast(ast), path);
+}
+
+void load_ast(const string& path, AST& ast) {
+    SourceBuffer file(path);
+    decode_ast(file.view(), ast);
+}
+
+void save_tac(const TACProgram& program, const string& path) {
+    save(encode_tac(program), path);
+}
+
+TACProgram load_tac(const string& path) {
+    SourceBuffer file(path);
+    return decode_tac(file.view());
+}
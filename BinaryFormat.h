@@ -0,0 +1,26 @@
+#ifndef BINARYFORMAT_H
+#define BINARYFORMAT_H
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "ASTNode.h"
+#include "TAC.h"
+
+// Binary images of the AST and of TAC, so a run can resume after the parser
+// or after TAC generation. An image is an 8-byte magic, a format version and
+// then fixed-width little-endian records; loading maps the file and copies the
+// records out without any text parsing. Images written by another version are
+// rejected, as is anything truncated or out of range.
+const uint32_t BINARY_FORMAT_VERSION = 3;
+
+std::string encode_ast(const AST& ast);
+void decode_ast(std::string_view image, AST& ast);
+std::string encode_tac(const TACProgram& program);
+TACProgram decode_tac(std::string_view image);
+
+void save_ast(const AST& ast, const std::string& path);
+void load_ast(const std::string& path, AST& ast);
+void save_tac(const TACProgram& program, const std::string& path);
+TACProgram load_tac(const std::string& path);
+
+#endif // BINARYFORMAT_H
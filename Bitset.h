@@ -0,0 +1,57 @@
+#ifndef BITSET_H
+#define BITSET_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fixed-size set of small integers packed 64 to a word, for dataflow facts
+// over dense variable indices.
+class Bitset {
+public:
+    Bitset() : n(0) {}
+    explicit Bitset(size_t size) : n(size), words((size + 63) / 64, 0) {}
+
+    size_t size() const { return n; }
+    bool test(size_t i) const { return (words[i >> 6] >> (i & 63)) & 1; }
+    void set(size_t i) { words[i >> 6] |= uint64_t(1) << (i & 63); }
+    void reset(size_t i) { words[i >> 6] &= ~(uint64_t(1) << (i & 63)); }
+    void set_all() {
+        for (auto& w : words) w = ~uint64_t(0);
+        if (n & 63) words.back() &= (uint64_t(1) << (n & 63)) - 1;
+    }
+    void clear() {
+        for (auto& w : words) w = 0;
+    }
+
+    // this |= o; returns whether any bit was added.
+    bool merge(const Bitset& o) {
+        uint64_t added = 0;
+        for (size_t i = 0; i < words.size(); ++i) {
+            added |= o.words[i] & ~words[i];
+            words[i] |= o.words[i];
+        }
+        return added != 0;
+    }
+
+    bool operator==(const Bitset& o) const { return words == o.words; }
+    bool operator!=(const Bitset& o) const { return words != o.words; }
+
+    template <typename F>
+    void for_each(F fn) const {
+        for (size_t i = 0; i < words.size(); ++i) {
+            for (uint64_t w = words[i]; w; w &= w - 1) fn(i * 64 + __builtin_ctzll(w));
+        }
+    }
+
+    size_t count() const {
+        size_t c = 0;
+        for (uint64_t w : words) c += __builtin_popcountll(w);
+        return c;
+    }
+
+private:
+    size_t n;
+    std::vector<uint64_t> words;
+};
+
+#endif // BITSET_H
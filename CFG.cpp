@@ -0,0 +1,63 @@
+#include "CFG.h"
+using namespace std;
+
+static bool ends_block(TACOp op) {
+    return op == TACOp::GOTO || op == TACOp::IF_FALSE || op == TACOp::RETURN;
+}
+
+CFG::CFG(const vector<TACInstr>& code) {
+    uint32_t n = static_cast<uint32_t>(code.size());
+    uint32_t begin = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+        if (code[i].op == TACOp::LABEL && i > begin) {
+            blocks.push_back(BasicBlock{begin, i, {}, {}});
+            begin = i;
+        }
+        if (code[i].op == TACOp::LABEL) label_block[code[i].label] = static_cast<BlockId>(blocks.size());
+        if (ends_block(code[i].op)) {
+            blocks.push_back(BasicBlock{begin, i + 1, {}, {}});
+            begin = i + 1;
+        }
+    }
+    if (begin < n) blocks.push_back(BasicBlock{begin, n, {}, {}});
+
+    auto edge = [this](BlockId from, BlockId to) {
+        if (to == NO_BLOCK) return;
+        blocks[from].succs.push_back(to);
+        blocks[to].preds.push_back(from);
+    };
+    for (BlockId b = 0; b < blocks.size(); ++b) {
+        const TACInstr& last = code[blocks[b].end - 1];
+        BlockId next = b + 1 < blocks.size() ? b + 1 : NO_BLOCK;
+        switch (last.op) {
+            case TACOp::GOTO:
+                edge(b, block_of_label(last.label));
+                break;
+            case TACOp::IF_FALSE:
+                edge(b, next);
+                if (block_of_label(last.label) != next) edge(b, block_of_label(last.label));
+                break;
+            case TACOp::RETURN:
+                break;
+            default:
+                edge(b, next);
+        }
+    }
+}
+
+BlockId CFG::block_of_label(int32_t label) const {
+    auto it = label_block.find(label);
+    return it == label_block.end() ? NO_BLOCK : it->second;
+}
+
+string CFG::repr() const {
+    string out;
+    for (BlockId b = 0; b < blocks.size(); ++b) {
+        out += "B" + to_string(b) + " [" + to_string(blocks[b].begin) + ", " + to_string(blocks[b].end) + ") preds:";
+        for (BlockId p : blocks[b].preds) out += " B" + to_string(p);
+        out += " succs:";
+        for (BlockId s : blocks[b].succs) out += " B" + to_string(s);
+        out += "\n";
+    }
+    return out;
+}
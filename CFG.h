@@ -0,0 +1,42 @@
+#ifndef CFG_H
+#define CFG_H
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "TAC.h"
+
+typedef uint32_t BlockId;
+
+// A maximal straight-line run of instructions: it is only entered at its
+// first instruction and only left after its last one.
+struct BasicBlock {
+    uint32_t begin;               // [begin, end) in the function's code
+    uint32_t end;
+    std::vector<BlockId> preds;
+    std::vector<BlockId> succs;
+
+    uint32_t size() const { return end - begin; }
+};
+
+// Control-flow graph over one function's code. Blocks are in code order and
+// blocks[0] is the entry. Blocks start at labels and after goto, ifFalse and
+// return. The graph indexes into the code it was built from, so it has to be
+// rebuilt after the code changes.
+class CFG {
+public:
+    static constexpr BlockId NO_BLOCK = UINT32_MAX;
+
+    explicit CFG(const std::vector<TACInstr>& code);
+
+    std::vector<BasicBlock> blocks;
+
+    BlockId block_of_label(int32_t label) const;
+    size_t size() const { return blocks.size(); }
+    std::string repr() const;
+
+private:
+    std::unordered_map<int32_t, BlockId> label_block;
+};
+
+#endif // CFG_H
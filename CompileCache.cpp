@@ -0,0 +1,114 @@
+#include "CompileCache.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include "BinaryFormat.h"
+using namespace std;
+
+namespace {
+
+// 64-bit FNV-1a.
+const uint64_t FNV_OFFSET = 14695981039346656037ull;
+const uint64_t FNV_PRIME = 1099511628211ull;
+
+void mix(uint64_t& h, const void* data, size_t n) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < n; ++i) {
+        h ^= p[i];
+        h *= FNV_PRIME;
+    }
+}
+
+// Lengths go in ahead of the bytes, so "ab" "c" and "a" "bc" hash apart.
+void mix_text(uint64_t& h, const string& text) {
+    uint32_t n = static_cast<uint32_t>(text.size());
+    mix(h, &n, sizeof n);
+    mix(h, text.data(), text.size());
+}
+
+// Stands for the running compiler build: a hash of its executable, or of the
+// time this file was compiled where the executable cannot be read.
+uint64_t build_id() {
+    uint64_t h = FNV_OFFSET;
+    ifstream exe("/proc/self/exe", ios::binary);
+    char buffer[1 << 16];
+    bool read = false;
+    while (exe.read(buffer, sizeof buffer) || exe.gcount() > 0) {
+        mix(h, buffer, static_cast<size_t>(exe.gcount()));
+        read = true;
+    }
+    if (!read) mix_text(h, __DATE__ " " __TIME__);
+    return h;
+}
+
+} // namespace
+
+CompileCache::CompileCache(const string& dir_, const OptimizerOptions& options) : dir(dir_), settings(FNV_OFFSET) {
+    filesystem::create_directories(dir);
+    mix_text(settings, "format " + to_string(BINARY_FORMAT_VERSION));
+    mix_text(settings, "build " + to_string(build_id()));
+    for (const auto& pass : options.passes.empty() ? Optimizer::default_pipeline() : options.passes) mix_text(settings, pass);
+    mix_text(settings, "unroll " + to_string(options.unroll_factor) + " " + to_string(options.unroll_budget));
+    mix_text(settings, "vector " + to_string(options.vector_width));
+}
+
+uint64_t CompileCache::key(const Token* first, const Token* last) const {
+    uint64_t h = settings;
+    for (const Token* t = first; t != last; ++t) {
+        unsigned char kind = static_cast<unsigned char>(t->kind);
+        uint32_t n = static_cast<uint32_t>(t->value.size());
+        mix(h, &kind, 1);
+        mix(h, &n, sizeof n);
+        mix(h, t->value.data(), t->value.size());
+    }
+    return h;
+}
+
+string CompileCache::path(uint64_t key) const {
+    char name[24];
+    snprintf(name, sizeof name, "%016llx.tac", static_cast<unsigned long long>(key));
+    return dir + "/" + name;
+}
+
+// An entry is a TAC image holding the function as generated, then optimized.
+bool CompileCache::load(uint64_t key, TACFunction& tac, TACFunction& optimized) const {
+    string file = path(key);
+    error_code ec;
+    if (!filesystem::exists(file, ec)) return false;
+    try {
+        TACProgram entry = load_tac(file);
+        if (entry.functions.size() != 2) return false;
+        tac = move(entry.functions[0]);
+        optimized = move(entry.functions[1]);
+        return true;
+    } catch (const exception&) {
+        return false;
+    }
+}
+
+bool CompileCache::store(uint64_t key, const TACFunction& tac, const TACFunction& optimized) const {
+    static atomic<unsigned> stored{0};
+    string file = path(key);
+    string temp = file + "." + to_string(hash<thread::id>()(this_thread::get_id()) ^ chrono::steady_clock::now().time_since_epoch().count())
+                  + "." + to_string(stored++);
+    TACProgram entry;
+    entry.functions.push_back(tac);
+    entry.functions.push_back(optimized);
+    try {
+        save_tac(entry, temp);
+    } catch (const exception&) {
+        error_code ec;
+        filesystem::remove(temp, ec);
+        return false;
+    }
+    error_code ec;
+    filesystem::rename(temp, file, ec);
+    if (!ec) return true;
+    filesystem::remove(temp, ec);
+    return false;
+}
@@ -0,0 +1,33 @@
+#ifndef COMPILECACHE_H
+#define COMPILECACHE_H
+#include <cstdint>
+#include <string>
+#include "Optimizer.h"
+#include "TAC.h"
+#include "Token.h"
+
+// On-disk store of the TAC of single functions, before and after
+// optimization. An entry is keyed by a hash of the function's tokens (kinds
+// and text, not line numbers) and of the optimizer settings, so a function
+// whose source is unchanged skips TAC generation and the optimizer. Entries
+// are TAC images written under a temporary name and renamed into place, so
+// concurrent compilers sharing a directory never see half an entry. The key
+// also covers the compiler binary itself, so after a rebuild old entries are
+// missed rather than served.
+class CompileCache {
+public:
+    CompileCache(const std::string& dir, const OptimizerOptions& options);
+
+    uint64_t key(const Token* first, const Token* last) const;
+    // False when there is no usable entry; a damaged one counts as missing.
+    bool load(uint64_t key, TACFunction& tac, TACFunction& optimized) const;
+    // False if the entry could not be written; the compile goes on without it.
+    bool store(uint64_t key, const TACFunction& tac, const TACFunction& optimized) const;
+
+private:
+    std::string dir;
+    uint64_t settings; // hash of the options that change optimized code
+    std::string path(uint64_t key) const;
+};
+
+#endif // COMPILECACHE_H
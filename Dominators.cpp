@@ -0,0 +1,97 @@
+#include "Dominators.h"
+#include <utility>
+using namespace std;
+
+DominatorTree::DominatorTree(const CFG& cfg)
+    : idom(cfg.size(), CFG::NO_BLOCK), children(cfg.size()),
+      rpo_index(cfg.size(), UINT32_MAX), pre(cfg.size(), 0), post(cfg.size(), 0) {
+    size_t n = cfg.size();
+    if (n == 0) return;
+
+    // Postorder by an explicit DFS; deep block chains would overflow recursion.
+    vector<BlockId> order;
+    vector<char> seen(n, 0);
+    vector<pair<BlockId, size_t>> stack;
+    stack.push_back(make_pair(BlockId(0), size_t(0)));
+    seen[0] = 1;
+    while (!stack.empty()) {
+        BlockId b = stack.back().first;
+        size_t& next = stack.back().second;
+        if (next < cfg.blocks[b].succs.size()) {
+            BlockId s = cfg.blocks[b].succs[next++];
+            if (!seen[s]) {
+                seen[s] = 1;
+                stack.push_back(make_pair(s, size_t(0)));
+            }
+        } else {
+            order.push_back(b);
+            stack.pop_back();
+        }
+    }
+    rpo.assign(order.rbegin(), order.rend());
+    for (uint32_t i = 0; i < rpo.size(); ++i) rpo_index[rpo[i]] = i;
+
+    auto intersect = [this](BlockId a, BlockId b) {
+        while (a != b) {
+            while (rpo_index[a] > rpo_index[b]) a = idom[a];
+            while (rpo_index[b] > rpo_index[a]) b = idom[b];
+        }
+        return a;
+    };
+    idom[0] = 0;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 1; i < rpo.size(); ++i) {
+            BlockId b = rpo[i];
+            BlockId new_idom = CFG::NO_BLOCK;
+            for (BlockId p : cfg.blocks[b].preds) {
+                if (idom[p] == CFG::NO_BLOCK) continue;
+                new_idom = new_idom == CFG::NO_BLOCK ? p : intersect(p, new_idom);
+            }
+            if (idom[b] != new_idom) {
+                idom[b] = new_idom;
+                changed = true;
+            }
+        }
+    }
+    idom[0] = CFG::NO_BLOCK;
+    for (size_t i = 1; i < rpo.size(); ++i) children[idom[rpo[i]]].push_back(rpo[i]);
+
+    // Pre/post numbers on the tree answer dominance queries in O(1).
+    uint32_t clock = 0;
+    vector<pair<BlockId, size_t>> walk;
+    walk.push_back(make_pair(BlockId(0), size_t(0)));
+    pre[0] = clock++;
+    while (!walk.empty()) {
+        BlockId b = walk.back().first;
+        size_t& next = walk.back().second;
+        if (next < children[b].size()) {
+            BlockId c = children[b][next++];
+            pre[c] = clock++;
+            walk.push_back(make_pair(c, size_t(0)));
+        } else {
+            post[b] = clock++;
+            walk.pop_back();
+        }
+    }
+}
+
+bool DominatorTree::dominates(BlockId a, BlockId b) const {
+    if (!reachable(a) || !reachable(b)) return false;
+    return pre[a] <= pre[b] && post[b] <= post[a];
+}
+
+vector<vector<BlockId>> DominatorTree::frontiers(const CFG& cfg) const {
+    vector<vector<BlockId>> df(cfg.size());
+    for (BlockId b : rpo) {
+        if (cfg.blocks[b].preds.size() < 2) continue;
+        for (BlockId p : cfg.blocks[b].preds) {
+            if (!reachable(p)) continue;
+            for (BlockId runner = p; runner != idom[b]; runner = idom[runner]) {
+                if (df[runner].empty() || df[runner].back() != b) df[runner].push_back(b);
+            }
+        }
+    }
+    return df;
+}
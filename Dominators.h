@@ -0,0 +1,27 @@
+#ifndef DOMINATORS_H
+#define DOMINATORS_H
+#include <vector>
+#include "CFG.h"
+
+// Dominator tree of a CFG rooted at its entry block, computed with the
+// Cooper-Harvey-Kennedy iteration over reverse postorder. Blocks that cannot
+// be reached from the entry have no immediate dominator and are left out of
+// rpo and of the tree.
+class DominatorTree {
+public:
+    explicit DominatorTree(const CFG& cfg);
+
+    std::vector<BlockId> idom;                  // NO_BLOCK for the entry and unreachable blocks
+    std::vector<std::vector<BlockId>> children; // dominator tree edges
+    std::vector<BlockId> rpo;                   // reachable blocks in reverse postorder
+
+    bool reachable(BlockId b) const { return b == 0 ? !rpo.empty() : idom[b] != CFG::NO_BLOCK; }
+    bool dominates(BlockId a, BlockId b) const; // reflexive
+    std::vector<std::vector<BlockId>> frontiers(const CFG& cfg) const;
+
+private:
+    std::vector<uint32_t> rpo_index;
+    std::vector<uint32_t> pre, post; // dominator tree DFS numbering
+};
+
+#endif // DOMINATORS_H
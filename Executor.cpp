@@ -0,0 +1,263 @@
+#include "Executor.h"
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+using namespace std;
+
+#if defined(__GNUC__)
+#define THREADED_DISPATCH 1 // computed goto: GCC and Clang
+#endif
+
+namespace {
+
+// TACOp without LABEL, plus END, which ends code that runs off its last instruction.
+enum Op : uint8_t {
+    COPY, ADD, SUB, MUL, DIV, SHL, SHR, LT, GT, LE, GE, EQ, NE,
+    LOAD, STORE, VLOAD, VSTORE, VADD, VSUB, VMUL, VSPLAT, VSUM,
+    GOTO, IF_FALSE, RETURN, END,
+    OP_COUNT
+};
+
+Op op_of(TACOp op) {
+    switch (op) {
+        case TACOp::GOTO:     return GOTO;
+        case TACOp::IF_FALSE: return IF_FALSE;
+        case TACOp::RETURN:   return RETURN;
+        default:              return static_cast<Op>(op); // COPY..VSUM line up
+    }
+}
+
+} // namespace
+
+Executor::Executor(const TACFunction& f) : width(f.vector_width) {
+    // Labels take no room in the bytecode: each one names the index of the
+    // instruction that follows it.
+    unordered_map<int32_t, int32_t> target;
+    int32_t n = 0;
+    for (const auto& in : f.code) {
+        if (in.op == TACOp::LABEL) target[in.label] = n;
+        else ++n;
+    }
+
+    size_t names = f.vars.size() + static_cast<size_t>(f.temp_count) + 1;
+    frame.assign(names, 0);
+    unordered_map<int32_t, int32_t> constants;
+    auto slot = [&](const Operand& o) -> int32_t {
+        switch (o.kind) {
+            case Operand::VAR:  return o.value;
+            case Operand::TEMP: return static_cast<int32_t>(f.vars.size()) + o.value;
+            case Operand::CONST: {
+                auto it = constants.find(o.value);
+                if (it != constants.end()) return it->second;
+                frame.push_back(o.value);
+                return constants[o.value] = static_cast<int32_t>(frame.size() - 1);
+            }
+            default: return 0;
+        }
+    };
+    for (const auto& a : f.arrays) {
+        arrays.push_back(Array{static_cast<int32_t>(memory_size), a.length});
+        memory_size += static_cast<size_t>(a.length);
+    }
+    unordered_map<int32_t, int32_t> vector_offset;
+    auto vec = [&](const Operand& o) {
+        auto it = vector_offset.find(o.value);
+        if (it != vector_offset.end()) return it->second;
+        vector_size += static_cast<size_t>(width);
+        return vector_offset[o.value] = static_cast<int32_t>(vector_size) - width;
+    };
+
+    code.reserve(n + 1);
+    for (const auto& in : f.code) {
+        if (in.op == TACOp::LABEL) continue;
+        Instr out{nullptr, op_of(in.op), 0, slot(in.a), slot(in.b)};
+        switch (in.op) {
+            case TACOp::GOTO:
+            case TACOp::IF_FALSE: out.dst = target.at(in.label); break;
+            case TACOp::LOAD:     out.dst = slot(in.dst); out.b = in.label; break;
+            case TACOp::STORE:    out.dst = in.label; break;
+            case TACOp::VLOAD:    out.dst = vec(in.dst); out.b = in.label; break;
+            case TACOp::VSTORE:   out.dst = in.label; out.b = vec(in.b); break;
+            case TACOp::VADD:
+            case TACOp::VSUB:
+            case TACOp::VMUL:     out.dst = vec(in.dst); out.a = vec(in.a); out.b = vec(in.b); break;
+            case TACOp::VSPLAT:   out.dst = vec(in.dst); break;
+            case TACOp::VSUM:     out.dst = slot(in.dst); out.a = vec(in.a); break;
+            default:              out.dst = slot(in.dst); break;
+        }
+        code.push_back(out);
+    }
+    code.push_back(Instr{nullptr, END, 0, 0, 0});
+
+#ifdef THREADED_DISPATCH
+    const void* const* handlers = nullptr;
+    Result unused;
+    execute(nullptr, nullptr, nullptr, nullptr, 0, unused, &handlers);
+    for (auto& in : code) in.handler = handlers[in.op];
+#endif
+}
+
+Executor::Result Executor::run(uint64_t limit) const {
+    vector<int32_t> slots = frame;
+    vector<int32_t> memory(memory_size, 0), vectors(vector_size, 0);
+    Result result{true, false, 0, 0, 0};
+    auto start = chrono::steady_clock::now();
+    execute(code.data(), slots.data(), memory.data(), vectors.data(), limit, result, nullptr);
+    result.ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+// Called with handlers set, only hands out the handler addresses, which are
+// not visible outside this function. The step limit is only checked at jumps:
+// straight-line code cannot run for long.
+void Executor::execute(const Instr* ip, int32_t* s, int32_t* m, int32_t* v, uint64_t limit, Result& result,
+                       const void* const** handlers) const {
+    const Instr* base = ip;
+    const Array* tab = arrays.data();
+    const int32_t w = width;
+    uint64_t steps = 0;
+#ifdef THREADED_DISPATCH
+    static const void* const table[OP_COUNT] = {
+        &&op_COPY, &&op_ADD, &&op_SUB, &&op_MUL, &&op_DIV, &&op_SHL, &&op_SHR,
+        &&op_LT, &&op_GT, &&op_LE, &&op_GE, &&op_EQ, &&op_NE,
+        &&op_LOAD, &&op_STORE, &&op_VLOAD, &&op_VSTORE, &&op_VADD, &&op_VSUB, &&op_VMUL, &&op_VSPLAT, &&op_VSUM,
+        &&op_GOTO, &&op_IF_FALSE, &&op_RETURN, &&op_END
+    };
+    if (handlers) {
+        *handlers = table;
+        return;
+    }
+#define OP(name) op_##name
+#define NEXT() goto *ip->handler
+    NEXT();
+#else
+    (void)handlers;
+#define OP(name) case name
+#define NEXT() goto dispatch
+dispatch:
+    switch (ip->op) {
+#endif
+#define BINARY(name, expr)                              \
+    OP(name): {                                         \
+        int32_t a = s[ip->a], b = s[ip->b];             \
+        s[ip->dst] = (expr);                            \
+        ++steps;                                        \
+        ++ip;                                           \
+        NEXT();                                         \
+    }
+    OP(COPY):
+        s[ip->dst] = s[ip->a];
+        ++steps;
+        ++ip;
+        NEXT();
+    BINARY(ADD, static_cast<int32_t>(static_cast<uint32_t>(a) + static_cast<uint32_t>(b)))
+    BINARY(SUB, static_cast<int32_t>(static_cast<uint32_t>(a) - static_cast<uint32_t>(b)))
+    BINARY(MUL, static_cast<int32_t>(static_cast<uint32_t>(a) * static_cast<uint32_t>(b)))
+    BINARY(DIV, b == 0 ? 0 : (a == INT32_MIN && b == -1) ? INT32_MIN : a / b)
+    BINARY(SHL, static_cast<int32_t>(static_cast<uint32_t>(a) << (b & 31)))
+    BINARY(SHR, a >> (b & 31))
+    BINARY(LT, a < b)
+    BINARY(GT, a > b)
+    BINARY(LE, a <= b)
+    BINARY(GE, a >= b)
+    BINARY(EQ, a == b)
+    BINARY(NE, a != b)
+    // Indexes are compared unsigned, so a negative one is out of range too.
+    OP(LOAD): {
+        Array arr = tab[ip->b];
+        uint32_t i = static_cast<uint32_t>(s[ip->a]);
+        s[ip->dst] = i < static_cast<uint32_t>(arr.length) ? m[arr.base + i] : 0;
+        ++steps;
+        ++ip;
+        NEXT();
+    }
+    OP(STORE): {
+        Array arr = tab[ip->dst];
+        uint32_t i = static_cast<uint32_t>(s[ip->a]);
+        if (i < static_cast<uint32_t>(arr.length)) m[arr.base + i] = s[ip->b];
+        ++steps;
+        ++ip;
+        NEXT();
+    }
+    OP(VLOAD): {
+        Array arr = tab[ip->b];
+        uint32_t i = static_cast<uint32_t>(s[ip->a]);
+        int32_t* d = v + ip->dst;
+        if (arr.length >= w && i <= static_cast<uint32_t>(arr.length - w)) {
+            copy_n(m + arr.base + i, w, d);
+        } else {
+            for (int32_t k = 0; k < w; ++k, ++i) d[k] = i < static_cast<uint32_t>(arr.length) ? m[arr.base + i] : 0;
+        }
+        ++steps;
+        ++ip;
+        NEXT();
+    }
+    OP(VSTORE): {
+        Array arr = tab[ip->dst];
+        uint32_t i = static_cast<uint32_t>(s[ip->a]);
+        const int32_t* x = v + ip->b;
+        for (int32_t k = 0; k < w; ++k, ++i) {
+            if (i < static_cast<uint32_t>(arr.length)) m[arr.base + i] = x[k];
+        }
+        ++steps;
+        ++ip;
+        NEXT();
+    }
+#define VECTOR(name, op)                                                    \
+    OP(name): {                                                             \
+        const int32_t* x = v + ip->a;                                       \
+        const int32_t* y = v + ip->b;                                       \
+        int32_t* d = v + ip->dst;                                           \
+        for (int32_t k = 0; k < w; ++k) {                                   \
+            uint32_t r = static_cast<uint32_t>(x[k]) op static_cast<uint32_t>(y[k]); \
+            d[k] = static_cast<int32_t>(r);                                 \
+        }                                                                   \
+        ++steps;                                                            \
+        ++ip;                                                               \
+        NEXT();                                                             \
+    }
+    VECTOR(VADD, +)
+    VECTOR(VSUB, -)
+    VECTOR(VMUL, *)
+    OP(VSPLAT):
+        fill_n(v + ip->dst, w, s[ip->a]);
+        ++steps;
+        ++ip;
+        NEXT();
+    OP(VSUM): {
+        uint32_t sum = 0;
+        for (int32_t k = 0; k < w; ++k) sum += static_cast<uint32_t>(v[ip->a + k]);
+        s[ip->dst] = static_cast<int32_t>(sum);
+        ++steps;
+        ++ip;
+        NEXT();
+    }
+    OP(GOTO):
+        if (++steps > limit) goto stopped;
+        ip = base + ip->dst;
+        NEXT();
+    OP(IF_FALSE):
+        if (++steps > limit) goto stopped;
+        ip = s[ip->a] ? ip + 1 : base + ip->dst;
+        NEXT();
+    OP(RETURN):
+        result.returned = true;
+        result.value = s[ip->a];
+        result.steps = steps + 1;
+        return;
+    OP(END):
+        result.steps = steps;
+        return;
+#ifndef THREADED_DISPATCH
+    default:
+        return;
+    }
+#endif
+stopped:
+    result.finished = false;
+    result.steps = steps;
+#undef VECTOR
+#undef BINARY
+#undef NEXT
+#undef OP
+}
@@ -0,0 +1,56 @@
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+#include <cstdint>
+#include <vector>
+#include "TAC.h"
+
+// Runs a TACFunction. The code is decoded once into compact bytecode: labels
+// are dropped and jumps hold the index they go to, and every scalar operand
+// is a slot in one frame array holding the variables, the temporaries and the
+// constants. Arrays share one zeroed block of memory and vector temporaries
+// another, width slots each. Dispatch is direct-threaded (each instruction
+// holds the address of its handler) where the compiler supports computed
+// goto, and a switch elsewhere. Variables start at 0 and arithmetic follows
+// fold_binary; a V op counts as one instruction.
+class Executor {
+public:
+    struct Result {
+        bool finished;  // false if it was stopped at the step limit
+        bool returned;  // false if the code ran off its end
+        int32_t value;  // the value returned
+        uint64_t steps; // instructions executed, labels not counted
+        double ns;      // wall time of the run
+    };
+
+    explicit Executor(const TACFunction& f);
+    // Stops once limit instructions have run, at the next jump, so code that
+    // loops forever comes back unfinished.
+    Result run(uint64_t limit) const;
+    size_t code_size() const { return code.size(); }
+
+private:
+    // Loads and stores keep their array in b and dst; vector operands are
+    // offsets into the vector block.
+    struct Instr {
+        const void* handler; // threaded dispatch only
+        uint8_t op;
+        int32_t dst;         // slot written, or the jump target of GOTO and IF_FALSE
+        int32_t a;
+        int32_t b;
+    };
+    struct Array {
+        int32_t base;        // offset in the array block
+        int32_t length;
+    };
+    std::vector<Instr> code;
+    std::vector<int32_t> frame; // initial slot values: zeroed names, then the constants
+    std::vector<Array> arrays;
+    size_t memory_size = 0;     // ints in the array block
+    size_t vector_size = 0;     // ints in the vector block
+    int32_t width;
+
+    void execute(const Instr* ip, int32_t* slots, int32_t* memory, int32_t* vectors, uint64_t limit, Result& result,
+                 const void* const** handlers) const;
+};
+
+#endif // EXECUTOR_H
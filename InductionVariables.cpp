@@ -0,0 +1,104 @@
+#include "InductionVariables.h"
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+using namespace std;
+
+// The constant in an assignment of the form v = v +/- c.
+static bool increment_of(const TACInstr& in, const Operand& v, int32_t& step) {
+    if (in.op == TACOp::ADD && in.a == v && in.b.is_const()) step = in.b.value;
+    else if (in.op == TACOp::ADD && in.b == v && in.a.is_const()) step = in.a.value;
+    else if (in.op == TACOp::SUB && in.a == v && in.b.is_const()) step = fold_binary(TACOp::SUB, 0, in.b.value);
+    else return false;
+    return true;
+}
+
+InductionVariables::InductionVariables(const TACFunction& f, const CFG& cfg, const LoopForest& forest)
+    : basic(forest.loops.size()), derived(forest.loops.size()) {
+    struct Write {
+        uint32_t instr;
+        uint32_t block_begin;
+    };
+    unordered_map<Operand, vector<Write>, OperandHash> writes;
+    unordered_set<Operand, OperandHash> nested; // written inside an inner loop
+    vector<Operand> names;                       // written names, by first assignment
+    unordered_map<Operand, size_t, OperandHash> basic_index;
+    for (size_t l = 0; l < forest.loops.size(); ++l) {
+        const Loop& loop = forest.loops[l];
+        writes.clear();
+        nested.clear();
+        names.clear();
+        for (BlockId b : loop.blocks) {
+            const BasicBlock& bb = cfg.blocks[b];
+            for (uint32_t i = bb.begin; i < bb.end; ++i) {
+                const TACInstr& in = f.code[i];
+                if (!in.has_dst()) continue;
+                auto& w = writes[in.dst];
+                if (w.empty()) names.push_back(in.dst);
+                w.push_back(Write{i, bb.begin});
+                if (forest.loop_of[b] != static_cast<int>(l)) nested.insert(in.dst);
+            }
+        }
+
+        for (const Operand& v : names) {
+            if (nested.count(v)) continue;
+            const vector<Write>& ws = writes[v];
+            BasicIV iv;
+            iv.var = v;
+            for (size_t k = 0; k < ws.size(); ++k) {
+                const TACInstr& in = f.code[ws[k].instr];
+                int32_t step;
+                if (!increment_of(in, v, step)) {
+                    // v = t, where t's last assignment before it is t = v +/- c,
+                    // earlier in the same block and after v's last assignment.
+                    if (in.op != TACOp::COPY || in.a.kind != Operand::TEMP) break;
+                    const Write* def = nullptr;
+                    for (const Write& w : writes[in.a]) {
+                        if (w.block_begin == ws[k].block_begin && w.instr < ws[k].instr) def = &w;
+                    }
+                    if (!def || (k > 0 && ws[k - 1].instr > def->instr)) break;
+                    if (!increment_of(f.code[def->instr], v, step)) break;
+                }
+                iv.updates.push_back(ws[k].instr);
+                iv.steps.push_back(step);
+            }
+            if (iv.updates.size() != ws.size()) continue;
+            if (loop.preheader != CFG::NO_BLOCK) {
+                const BasicBlock& pre = cfg.blocks[loop.preheader];
+                for (uint32_t i = pre.end; i-- > pre.begin;) {
+                    const TACInstr& in = f.code[i];
+                    if (in.has_dst() && in.dst == v) {
+                        iv.start_known = in.op == TACOp::COPY && in.a.is_const();
+                        iv.start = in.a.value;
+                        break;
+                    }
+                }
+            }
+            basic[l].push_back(iv);
+        }
+
+        basic_index.clear();
+        for (size_t k = 0; k < basic[l].size(); ++k) basic_index[basic[l][k].var] = k;
+        for (BlockId b : loop.blocks) {
+            for (uint32_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; ++i) {
+                const TACInstr& in = f.code[i];
+                if (in.op != TACOp::MUL && in.op != TACOp::SHL) continue;
+                const Operand* var = &in.a;
+                const Operand* c = &in.b;
+                if (in.op == TACOp::MUL && in.a.is_const()) swap(var, c);
+                if (!c->is_const()) continue;
+                auto it = basic_index.find(*var);
+                if (it == basic_index.end()) continue;
+                int32_t scale = in.op == TACOp::MUL ? c->value : fold_binary(TACOp::SHL, 1, c->value);
+                derived[l].push_back(DerivedIV{i, it->second, scale});
+            }
+        }
+    }
+}
+
+const BasicIV* InductionVariables::find(int loop, const Operand& var) const {
+    for (const BasicIV& iv : basic[loop]) {
+        if (iv.var == var) return &iv;
+    }
+    return nullptr;
+}
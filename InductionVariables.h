@@ -0,0 +1,39 @@
+#ifndef INDUCTION_VARIABLES_H
+#define INDUCTION_VARIABLES_H
+#include <cstdint>
+#include <vector>
+#include "CFG.h"
+#include "Loops.h"
+#include "TAC.h"
+
+// A name whose every assignment in the loop adds a constant to it: v = v + c,
+// v = v - c, or v = t where t's last assignment before it in the same block
+// is t = v +/- c. None of the assignments may sit in a nested loop, so each
+// runs at most once per iteration of this one.
+struct BasicIV {
+    Operand var;
+    std::vector<uint32_t> updates; // instructions assigning var, in code order
+    std::vector<int32_t> steps;    // what each update adds, mod 2^32
+    bool start_known = false;
+    int32_t start = 0;             // constant var holds on entry, from the preheader
+};
+
+// dst = var * scale (or var << k) for a basic IV var of the same loop.
+struct DerivedIV {
+    uint32_t instr;
+    size_t basic;                  // index into the loop's basic IVs
+    int32_t scale;
+};
+
+// Basic and derived induction variables of every loop in a forest.
+class InductionVariables {
+public:
+    InductionVariables(const TACFunction& f, const CFG& cfg, const LoopForest& forest);
+
+    std::vector<std::vector<BasicIV>> basic;     // per loop
+    std::vector<std::vector<DerivedIV>> derived; // per loop
+
+    const BasicIV* find(int loop, const Operand& var) const; // nullptr if var is not basic there
+};
+
+#endif // INDUCTION_VARIABLES_H
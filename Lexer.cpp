@@ -1,84 +1,147 @@
 #include "Lexer.h"
-#include <fstream>
-#include <sstream>
-#include <regex>
-#include <iostream>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
 using namespace std;
 
-Lexer::Lexer(const string& filename) : current_line(1) {
-    ifstream file(filename);
-    if (!file) {
-        throw runtime_error("Cannot open file: " + filename);
+namespace {
+
+// Character classes driving the scanner's start state.
+enum CharClass : unsigned char {
+    C_OTHER, C_SPACE, C_NEWLINE, C_DIGIT, C_ALPHA, C_OP, C_PUNCT, C_RELOP, C_COMMENT
+};
+
+struct CharTable {
+    unsigned char cls[256];
+    CharTable() {
+        memset(cls, C_OTHER, sizeof(cls));
+        cls[(unsigned char)' '] = C_SPACE;
+        cls[(unsigned char)'\t'] = C_SPACE;
+        cls[(unsigned char)'\r'] = C_SPACE;
+        cls[(unsigned char)'\n'] = C_NEWLINE;
+        for (int c = '0'; c <= '9'; ++c) cls[c] = C_DIGIT;
+        for (int c = 'a'; c <= 'z'; ++c) cls[c] = C_ALPHA;
+        for (int c = 'A'; c <= 'Z'; ++c) cls[c] = C_ALPHA;
+        cls[(unsigned char)'_'] = C_ALPHA;
+        for (const char* p = "+-*/"; *p; ++p) cls[(unsigned char)*p] = C_OP;
+        for (const char* p = ";,(){}[]"; *p; ++p) cls[(unsigned char)*p] = C_PUNCT;
+        for (const char* p = "=<>!"; *p; ++p) cls[(unsigned char)*p] = C_RELOP;
+        cls[(unsigned char)'#'] = C_COMMENT;
     }
-    ostringstream ss;
-    string line;
-    while (getline(file, line)) {
-        size_t pos = line.find("//");
-        if (pos != string::npos) line = line.substr(0, pos);
-        pos = line.find('#');
-        if (pos != string::npos) line = line.substr(0, pos);
-        ss << line << '\n';
+};
+
+const CharTable char_table;
+
+inline bool is_word_char(char c) {
+    unsigned char k = char_table.cls[(unsigned char)c];
+    return k == C_ALPHA || k == C_DIGIT;
+}
+
+struct Keyword {
+    const char* text;
+    size_t length;
+    TokenKind kind;
+};
+
+const Keyword keywords[] = {
+    {"for", 3, TokenKind::FOR},
+    {"while", 5, TokenKind::WHILE},
+    {"if", 2, TokenKind::IF},
+    {"else", 4, TokenKind::ELSE},
+    {"int", 3, TokenKind::INT},
+    {"return", 6, TokenKind::RETURN},
+};
+
+TokenKind keyword_kind(const char* text, size_t length) {
+    for (const auto& kw : keywords) {
+        if (kw.length == length && memcmp(kw.text, text, length) == 0) return kw.kind;
     }
-    code = ss.str();
+    return TokenKind::ID;
 }
 
-vector<Token> Lexer::tokenize() {
-    vector<pair<string, string> > token_specification = {
-        make_pair("FOR",      "for"),
-        make_pair("WHILE",    "while"),
-        make_pair("IF",       "if"),
-        make_pair("ELSE",     "else"),
-        make_pair("INT",      "int"),
-        make_pair("RETURN",   "return"),
-        make_pair("NUMBER",   "\\d+"),
-        make_pair("ID",       "[A-Za-z_]\\w*"),
-        make_pair("ASSIGN",   "="),
-        make_pair("END",      ";"),
-        make_pair("COMMA",    ","),
-        make_pair("OP",       "[-+*/]"),
-        make_pair("LPAREN",   "\\("),
-        make_pair("RPAREN",   "\\)"),
-        make_pair("LBRACE",   "\\{"),
-        make_pair("RBRACE",   "\\}"),
-        make_pair("LE",       "<="),
-        make_pair("GE",       ">="),
-        make_pair("EQ",       "=="),
-        make_pair("NE",       "!="),
-        make_pair("LT",       "<"),
-        make_pair("GT",       ">"),
-        make_pair("SKIP",     "[ \\t]+"),
-        make_pair("NEWLINE",  "\\n"),
-        make_pair("MISMATCH", ".")
-    };
-    string::size_type pos = 0;
-    while (pos < code.size()) {
-        bool matched = false;
-        for (size_t i = 0; i < token_specification.size(); ++i) {
-            regex pattern("^" + token_specification[i].second);
-            smatch m;
-            string remaining = code.substr(pos);
-            if (regex_search(remaining, m, pattern)) {
-                if (m.position() == 0) {
-                    string kind = token_specification[i].first;
-                    string value = m.str();
-                    if (kind == "NEWLINE") {
-                        current_line++;
-                    } else if (kind == "SKIP") {
-                        // skip
-                    } else if (kind == "MISMATCH") {
-                        throw runtime_error("Unexpected character '" + value + "' on line " + to_string(current_line));
-                    } else {
-                        tokens.emplace_back(kind, value, current_line);
-                    }
-                    pos += m.length();
-                    matched = true;
+TokenKind punct_kind(char c) {
+    switch (c) {
+        case ';': return TokenKind::END;
+        case ',': return TokenKind::COMMA;
+        case '(': return TokenKind::LPAREN;
+        case ')': return TokenKind::RPAREN;
+        case '{': return TokenKind::LBRACE;
+        case '}': return TokenKind::RBRACE;
+        case '[': return TokenKind::LBRACKET;
+        default:  return TokenKind::RBRACKET;
+    }
+}
+
+} // namespace
+
+Lexer::Lexer(const string& filename) : source(filename), current_line(1) {}
+
+Lexer::Lexer(SourceBuffer::Text text) : source(move(text)), current_line(1) {}
+
+// Single left-to-right pass: the first character selects the token class and
+// each class consumes its longest match, so the cost is linear in the input.
+// `//` and `#` comments are skipped in place; token values are spans of the
+// source buffer.
+const vector<Token>& Lexer::tokenize() {
+    string_view code = source.view();
+    const char* p = code.data();
+    const char* end = p + code.size();
+    tokens.clear();
+    current_line = 1;
+    while (p < end) {
+        const char* start = p;
+        switch (char_table.cls[(unsigned char)*p]) {
+            case C_SPACE:
+                ++p;
+                break;
+            case C_NEWLINE:
+                ++p;
+                current_line++;
+                break;
+            case C_DIGIT:
+                while (p < end && char_table.cls[(unsigned char)*p] == C_DIGIT) ++p;
+                tokens.emplace_back(TokenKind::NUMBER, string_view(start, p - start), current_line);
+                break;
+            case C_ALPHA:
+                while (p < end && is_word_char(*p)) ++p;
+                tokens.emplace_back(keyword_kind(start, p - start), string_view(start, p - start), current_line);
+                break;
+            case C_COMMENT:
+                while (p < end && *p != '\n') ++p;
+                break;
+            case C_OP:
+                if (*p == '/' && p + 1 < end && p[1] == '/') {
+                    while (p < end && *p != '\n') ++p;
                     break;
                 }
+                ++p;
+                tokens.emplace_back(TokenKind::OP, string_view(start, p - start), current_line);
+                break;
+            case C_PUNCT:
+                ++p;
+                tokens.emplace_back(punct_kind(*start), string_view(start, p - start), current_line);
+                break;
+            case C_RELOP: {
+                bool eq_follows = p + 1 < end && p[1] == '=';
+                TokenKind kind;
+                switch (*p) {
+                    case '=': kind = eq_follows ? TokenKind::EQ : TokenKind::ASSIGN; break;
+                    case '<': kind = eq_follows ? TokenKind::LE : TokenKind::LT; break;
+                    case '>': kind = eq_follows ? TokenKind::GE : TokenKind::GT; break;
+                    default:
+                        if (!eq_follows) {
+                            throw runtime_error("Unexpected character '!' on line " + to_string(current_line));
+                        }
+                        kind = TokenKind::NE;
+                        break;
+                }
+                p += eq_follows ? 2 : 1;
+                tokens.emplace_back(kind, string_view(start, p - start), current_line);
+                break;
             }
-        }
-        if (!matched) {
-            throw runtime_error("Lexer error at position " + to_string(pos));
+            default:
+                throw runtime_error("Unexpected character '" + string(1, *p) + "' on line " + to_string(current_line));
         }
     }
     return tokens;
-} 
\ No newline at end of file
+}
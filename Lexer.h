@@ -2,17 +2,18 @@
 #define LEXER_H
 #include <string>
 #include <vector>
+#include "SourceBuffer.h"
 #include "Token.h"
 
 class Lexer {
 public:
     Lexer(const std::string& filename);
-    std::vector<Token> tokenize();
+    explicit Lexer(SourceBuffer::Text text);
+    const std::vector<Token>& tokenize();
 private:
-    std::string code;
+    SourceBuffer source;
     int current_line;
     std::vector<Token> tokens;
-    void strip_comments();
 };
 
-#endif // LEXER_H 
\ No newline at end of file
+#endif // LEXER_H
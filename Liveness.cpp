@@ -0,0 +1,60 @@
+#include "Liveness.h"
+using namespace std;
+
+Liveness::Liveness(const TACFunction& f_, const CFG& cfg_, bool strong_)
+    : f(f_), cfg(cfg_), strong(strong_), var_count(f_.vars.size()),
+      slots(f_.vars.size() + static_cast<size_t>(f_.temp_count) + 1, NO_SLOT) {
+    size_t blocks = cfg.size();
+    auto make_global = [this](size_t i) {
+        if (slots[i] == NO_SLOT) {
+            slots[i] = static_cast<uint32_t>(globals.size());
+            globals.push_back(static_cast<uint32_t>(i));
+        }
+    };
+    if (!f.has_header) {
+        for (size_t v = 0; v < var_count; ++v) make_global(v);
+    }
+    // A name read in a block before being written there may be live on
+    // entry; written_in holds the last block that wrote each name.
+    vector<uint32_t> written_in(universe(), CFG::NO_BLOCK);
+    for (BlockId b = 0; b < blocks; ++b) {
+        for (uint32_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; ++i) {
+            const TACInstr& in = f.code[i];
+            for (const Operand* o : {&in.a, &in.b}) {
+                if (o->is_name() && written_in[index(*o)] != b) make_global(index(*o));
+            }
+            if (in.has_dst()) written_in[index(in.dst)] = b;
+        }
+    }
+
+    size_t n = globals.size();
+    Bitset at_exit(n);
+    if (!f.has_header) at_exit.set_all();
+    live.assign(universe(), 0);
+    live_in.assign(blocks, Bitset(n));
+    live_out.assign(blocks, Bitset(n));
+    // Worklist seeded in reverse code order, which settles most forward
+    // code in a single round.
+    vector<BlockId> work;
+    vector<char> queued(blocks, 1);
+    for (BlockId b = 0; b < blocks; ++b) work.push_back(b);
+    while (!work.empty()) {
+        BlockId b = work.back();
+        work.pop_back();
+        queued[b] = 0;
+        const BasicBlock& bb = cfg.blocks[b];
+        Bitset& out = live_out[b];
+        if (bb.succs.empty() && f.code[bb.end - 1].op != TACOp::RETURN) out.merge(at_exit);
+        for (BlockId s : bb.succs) out.merge(live_in[s]);
+        Bitset in_set = walk(b, [](uint32_t, bool) {});
+        if (in_set != live_in[b]) {
+            live_in[b] = std::move(in_set);
+            for (BlockId p : bb.preds) {
+                if (!queued[p]) {
+                    queued[p] = 1;
+                    work.push_back(p);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef LIVENESS_H
+#define LIVENESS_H
+#include <cstdint>
+#include <vector>
+#include "Bitset.h"
+#include "CFG.h"
+#include "TAC.h"
+
+// Backward liveness over a function's CFG. Names get dense indices:
+// variable v is v, temporary tN is vars.size() + N. Only names that are read
+// in some block before being written there can be live across blocks, so
+// the per-block sets are kept over that smaller "global" subset.
+// A top-level statement list keeps all its variables live at exit; inside a
+// function only the returned value escapes.
+//
+// With strong set, an assignment to a dead name does not make its operands
+// live, so chains of assignments that only feed dead code are dead too.
+class Liveness {
+public:
+    static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+    Liveness(const TACFunction& f, const CFG& cfg, bool strong = false);
+
+    std::vector<Bitset> live_in;  // per block, over global slots
+    std::vector<Bitset> live_out;
+    std::vector<uint32_t> globals; // global slot -> name index
+
+    size_t index(const Operand& o) const {
+        return o.kind == Operand::VAR ? static_cast<size_t>(o.value) : var_count + static_cast<size_t>(o.value);
+    }
+    uint32_t slot(size_t index) const { return slots[index]; }
+    size_t universe() const { return slots.size(); }
+
+    // Walks block b backwards from its live-out set, calling
+    // visit(instr_index, dst_live) for every instruction; dst_live is false
+    // for an assignment to a dead name. Returns the live-in set.
+    template <typename F>
+    Bitset walk(BlockId b, F visit);
+
+private:
+    const TACFunction& f;
+    const CFG& cfg;
+    bool strong;
+    size_t var_count;
+    std::vector<uint32_t> slots;  // name index -> global slot or NO_SLOT
+    std::vector<char> live;       // scratch for walk(), by name index
+    std::vector<size_t> touched;  // entries of live to clear after a walk
+};
+
+template <typename F>
+Bitset Liveness::walk(BlockId b, F visit) {
+    auto mark = [this](size_t i, char v) {
+        live[i] = v;
+        touched.push_back(i);
+    };
+    live_out[b].for_each([&](size_t s) { mark(globals[s], 1); });
+    for (uint32_t i = cfg.blocks[b].end; i-- > cfg.blocks[b].begin;) {
+        const TACInstr& in = f.code[i];
+        if (in.has_dst()) {
+            size_t d = index(in.dst);
+            bool dst_live = live[d];
+            visit(i, dst_live);
+            if (!dst_live && strong) continue;
+            mark(d, 0);
+        } else {
+            visit(i, true);
+        }
+        if (in.a.is_name()) mark(index(in.a), 1);
+        if (in.b.is_name()) mark(index(in.b), 1);
+    }
+    Bitset in_set(globals.size());
+    for (size_t t : touched) {
+        if (live[t] && slots[t] != NO_SLOT) in_set.set(slots[t]);
+        live[t] = 0;
+    }
+    touched.clear();
+    return in_set;
+}
+
+#endif // LIVENESS_H
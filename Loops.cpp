@@ -0,0 +1,88 @@
+#include "Loops.h"
+#include <algorithm>
+using namespace std;
+
+LoopForest::LoopForest(const CFG& cfg, const DominatorTree& dom) : loop_of(cfg.size(), -1) {
+    // Collect latches per header, then grow each loop backwards from them.
+    vector<int> loop_at(cfg.size(), -1);
+    for (BlockId b : dom.rpo) {
+        for (BlockId s : cfg.blocks[b].succs) {
+            if (!dom.dominates(s, b)) continue;
+            if (loop_at[s] < 0) {
+                loop_at[s] = static_cast<int>(loops.size());
+                loops.push_back(Loop());
+                loops.back().header = s;
+            }
+            loops[loop_at[s]].latches.push_back(b);
+        }
+    }
+    vector<uint32_t> in_loop(cfg.size(), UINT32_MAX);
+    vector<BlockId> work;
+    for (uint32_t l = 0; l < loops.size(); ++l) {
+        Loop& loop = loops[l];
+        in_loop[loop.header] = l;
+        loop.blocks.push_back(loop.header);
+        for (BlockId latch : loop.latches) {
+            if (in_loop[latch] != l) {
+                in_loop[latch] = l;
+                loop.blocks.push_back(latch);
+                work.push_back(latch);
+            }
+        }
+        while (!work.empty()) {
+            BlockId b = work.back();
+            work.pop_back();
+            for (BlockId p : cfg.blocks[b].preds) {
+                if (in_loop[p] == l || !dom.reachable(p)) continue;
+                in_loop[p] = l;
+                loop.blocks.push_back(p);
+                work.push_back(p);
+            }
+        }
+        sort(loop.blocks.begin(), loop.blocks.end());
+    }
+
+    // Inner loops are smaller than the loops around them; visiting the big
+    // ones first leaves each block's innermost loop in loop_of and finds
+    // a loop's parent as whatever loop held its header before it.
+    sort(loops.begin(), loops.end(), [](const Loop& a, const Loop& b) {
+        return a.blocks.size() != b.blocks.size() ? a.blocks.size() > b.blocks.size() : a.header < b.header;
+    });
+    for (size_t l = 0; l < loops.size(); ++l) {
+        loops[l].parent = loop_of[loops[l].header];
+        for (BlockId b : loops[l].blocks) loop_of[b] = static_cast<int>(l);
+    }
+    reverse(loops.begin(), loops.end());
+    int n = static_cast<int>(loops.size());
+    for (auto& lo : loop_of) {
+        if (lo >= 0) lo = n - 1 - lo;
+    }
+    for (auto& loop : loops) {
+        if (loop.parent >= 0) loop.parent = n - 1 - loop.parent;
+    }
+    for (int l = n - 1; l >= 0; --l) {
+        if (loops[l].parent >= 0) {
+            loops[l].depth = loops[loops[l].parent].depth + 1;
+            loops[loops[l].parent].children.push_back(l);
+        }
+    }
+
+    for (auto& loop : loops) {
+        BlockId outside = CFG::NO_BLOCK;
+        int entries = 0;
+        for (BlockId p : cfg.blocks[loop.header].preds) {
+            if (!contains(static_cast<int>(&loop - loops.data()), p)) {
+                outside = p;
+                ++entries;
+            }
+        }
+        if (entries == 1 && cfg.blocks[outside].succs.size() == 1) loop.preheader = outside;
+    }
+}
+
+bool LoopForest::contains(int loop, BlockId b) const {
+    for (int l = loop_of[b]; l >= 0; l = loops[l].parent) {
+        if (l == loop) return true;
+    }
+    return false;
+}
@@ -0,0 +1,34 @@
+#ifndef LOOPS_H
+#define LOOPS_H
+#include <vector>
+#include "CFG.h"
+#include "Dominators.h"
+
+// A natural loop: the header plus every block that reaches one of its back
+// edges (latch -> header, where the header dominates the latch) without
+// passing through the header. Back edges sharing a header form one loop.
+struct Loop {
+    BlockId header;
+    std::vector<BlockId> blocks;   // in code order, header included
+    std::vector<BlockId> latches;
+    int parent = -1;               // enclosing loop, -1 at the top
+    std::vector<int> children;
+    int depth = 1;
+    // The single block outside the loop that enters it and leads only to
+    // the header, or NO_BLOCK when there is none yet.
+    BlockId preheader = CFG::NO_BLOCK;
+};
+
+// Loop nesting forest of a CFG. Loops are ordered inner before outer, so
+// walking loops front to back visits every loop after the ones nested in it.
+class LoopForest {
+public:
+    LoopForest(const CFG& cfg, const DominatorTree& dom);
+
+    std::vector<Loop> loops;
+    std::vector<int> loop_of;      // per block, innermost loop or -1
+
+    bool contains(int loop, BlockId b) const;
+};
+
+#endif // LOOPS_H
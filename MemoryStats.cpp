@@ -0,0 +1,40 @@
+#include "MemoryStats.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+static std::atomic<bool> counting(false);
+static std::atomic<size_t> allocations(0);
+
+void* operator new(size_t size) {
+    if (counting.load(std::memory_order_relaxed)) allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void count_allocations() {
+    counting.store(true, std::memory_order_relaxed);
+}
+
+size_t allocation_count() {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+size_t peak_rss_kb() {
+#ifndef _WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) return static_cast<size_t>(usage.ru_maxrss);
+#endif
+    return 0;
+}
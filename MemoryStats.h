@@ -0,0 +1,14 @@
+#ifndef MEMORYSTATS_H
+#define MEMORYSTATS_H
+#include <cstddef>
+
+// Turns on counting of global operator new calls. Counting takes one shared
+// atomic per allocation, which worker threads would contend on, so it is off
+// unless --stats asks for it.
+void count_allocations();
+// Number of global operator new calls counted so far.
+size_t allocation_count();
+// Peak resident set size of the process in kilobytes (0 if unavailable).
+size_t peak_rss_kb();
+
+#endif // MEMORYSTATS_H
@@ -1,492 +1,1446 @@
 #include "Optimizer.h"
-#include <regex>
+#include "CFG.h"
+#include "Liveness.h"
+#include "SSA.h"
+#include "Loops.h"
+#include "InductionVariables.h"
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <thread>
 #include <unordered_map>
+#include <map>
 #include <set>
+#include <tuple>
+#include <stdexcept>
+#include <algorithm>
 
-std::set<std::string> global_used_vars;
-
-Optimizer::Optimizer(const std::vector<std::string>& tac_) : tac(tac_) {}
-
-std::vector<std::string> Optimizer::optimize() {
-    std::vector<std::string> code = tac;
-    bool changed = true;
-    int max_passes = 10; // Prevent infinite loops
-    int pass = 0;
-    while (changed && pass < max_passes) {
-        changed = false;
-        std::vector<std::string> prev = code;
-        code = constant_propagation_and_folding(code);
-        code = constant_folding(code);
-        code = algebraic_simplification(code);
-        code = strength_reduction(code);
-        code = induction_variable_simplification(code);
-        code = loop_unrolling(code);
-        code = common_subexpression_elimination(code);
-        code = advanced_loop_invariant_code_motion(code);
-        code = remove_redundant_copies(code);
-        code = induction_variable_elimination(code);
-        code = full_dead_code_elimination(code);
-        if (code != prev) changed = true;
-        pass++;
-    }
-    return code;
+const Optimizer::PassInfo Optimizer::passes[] = {
+    {"sparse_conditional_constant_propagation", &Optimizer::sparse_conditional_constant_propagation, nullptr},
+    {"loop_vectorization", &Optimizer::loop_vectorization, nullptr},
+    {"algebraic_simplification", nullptr, &Optimizer::algebraic_simplification},
+    {"strength_reduction", nullptr, &Optimizer::strength_reduction},
+    {"loop_unrolling", &Optimizer::loop_unrolling, nullptr},
+    {"global_value_numbering", &Optimizer::global_value_numbering, nullptr},
+    {"loop_invariant_code_motion", &Optimizer::loop_invariant_code_motion, nullptr},
+    {"induction_variable_strength_reduction", &Optimizer::induction_variable_strength_reduction, nullptr},
+    {"remove_redundant_copies", nullptr, &Optimizer::remove_redundant_copies},
+    {"full_dead_code_elimination", &Optimizer::full_dead_code_elimination, nullptr},
+    {"remove_useless_assignments", nullptr, &Optimizer::remove_useless_assignments},
+};
+
+std::vector<std::string> Optimizer::pass_names() {
+    std::vector<std::string> names;
+    for (const auto& p : passes) names.push_back(p.name);
+    return names;
 }
 
-bool Optimizer::is_control_or_label(const std::string& line) const {
-    std::regex label_regex("^L\\d+:");
-    return (
-        line.find("function") == 0 ||
-        line.find("end function") == 0 ||
-        std::regex_search(line, label_regex) ||
-        line.find("ifFalse") == 0 ||
-        line.find("goto") == 0 ||
-        line.find("return") == 0
-    );
+std::vector<std::string> Optimizer::default_pipeline() {
+    std::vector<std::string> names = pass_names();
+    names.pop_back(); // remove_useless_assignments is opt-in
+    return names;
 }
 
-std::vector<std::string> Optimizer::constant_folding(const std::vector<std::string>& code) const {
-    std::vector<std::string> new_code;
-    std::regex re("(t\\d+) = (\\w+) ([-+*/]) (\\w+)");
-    std::unordered_map<std::string, int> const_vals;
-    for (const auto& line : code) {
-        if (is_control_or_label(line)) {
-            new_code.push_back(line);
-            continue;
+Optimizer::Optimizer(const TACProgram& tac_, const OptimizerOptions& options_) : tac(tac_), options(options_) {
+    std::vector<std::string> names = options.passes.empty() ? default_pipeline() : options.passes;
+    for (const auto& name : names) {
+        int found = -1;
+        for (size_t i = 0; i < sizeof(passes) / sizeof(passes[0]); ++i) {
+            if (name == passes[i].name) found = static_cast<int>(i);
         }
-        std::smatch m;
-        if (std::regex_match(line, m, re)) {
-            std::string t = m[1];
-            std::string a = m[2];
-            std::string op = m[3];
-            std::string b = m[4];
-            // Mark both operands as used for folding, always
-            global_used_vars.insert(a);
-            global_used_vars.insert(b);
-            // Try to parse a and b as constants
-            bool a_is_const = false, b_is_const = false;
-            int a_val = 0, b_val = 0;
-            try { a_val = std::stoi(a); a_is_const = true; } catch (...) {}
-            try { b_val = std::stoi(b); b_is_const = true; } catch (...) {}
-            if (a_is_const && b_is_const) {
-                int v = 0;
-                if (op == "+") v = a_val + b_val;
-                else if (op == "-") v = a_val - b_val;
-                else if (op == "*") v = a_val * b_val;
-                else if (op == "/") v = (b_val != 0) ? a_val / b_val : 0;
-                new_code.push_back(t + " = " + std::to_string(v));
-                continue;
-            }
-            if (const_vals.count(a) && const_vals.count(b)) {
-                int v = 0;
-                if (op == "+") v = const_vals[a] + const_vals[b];
-                else if (op == "-") v = const_vals[a] - const_vals[b];
-                else if (op == "*") v = const_vals[a] * const_vals[b];
-                else if (op == "/") v = (const_vals[b] != 0) ? const_vals[a] / const_vals[b] : 0;
-                new_code.push_back(t + " = " + std::to_string(v));
-                const_vals[t] = v;
-                continue;
+        if (found < 0) throw std::runtime_error("Unknown optimizer pass: " + name);
+        pipeline.push_back(found);
+        pass_stats.push_back(PassStats{name, 0, 0});
+    }
+}
+
+// With more than one job, workers take functions off a shared counter and
+// keep their own pass stats, which are added up once all are done.
+TACProgram Optimizer::optimize() {
+    TACProgram program = tac;
+    size_t n = program.functions.size();
+    size_t workers = std::max<size_t>(1, std::min<size_t>(options.jobs, n));
+    std::vector<PassStats> zero;
+    for (const auto& p : pass_stats) zero.push_back(PassStats{p.name});
+    std::vector<std::vector<PassStats>> worker_stats(workers, zero);
+    if (workers == 1) {
+        for (auto& f : program.functions) optimize_function(f, worker_stats[0]);
+    } else {
+        std::atomic<size_t> next(0);
+        std::vector<std::exception_ptr> errors(workers);
+        std::vector<std::thread> threads;
+        for (size_t w = 0; w < workers; ++w) {
+            threads.emplace_back([&, w] {
+                try {
+                    for (size_t i; (i = next++) < n;) optimize_function(program.functions[i], worker_stats[w]);
+                } catch (...) {
+                    errors[w] = std::current_exception();
+                    next = n;
+                }
+            });
+        }
+        for (auto& t : threads) t.join();
+        for (const auto& e : errors) {
+            if (e) std::rethrow_exception(e);
+        }
+    }
+    for (const auto& ws : worker_stats) {
+        for (size_t i = 0; i < pass_stats.size(); ++i) {
+            pass_stats[i].runs += ws[i].runs;
+            pass_stats[i].changes += ws[i].changes;
+            pass_stats[i].blocks_skipped += ws[i].blocks_skipped;
+            pass_stats[i].eliminated += ws[i].eliminated;
+            pass_stats[i].ms += ws[i].ms;
+        }
+    }
+    return program;
+}
+
+// Pass manager: every change bumps the function's version, and a pass is only
+// re-run when the code has changed since its last run. Sweeps over the
+// pipeline stop once a full sweep finds every pass up to date.
+void Optimizer::optimize_function(TACFunction& f, std::vector<PassStats>& stats) const {
+    long version = 0;
+    std::vector<long> seen(pipeline.size(), -1); // version each pass last ran on
+    std::vector<std::unordered_set<uint64_t>> clean(pipeline.size()); // block hashes a pass left alone
+    for (int sweep = 0; sweep < max_sweeps; ++sweep) {
+        bool ran = false;
+        for (size_t i = 0; i < pipeline.size(); ++i) {
+            if (seen[i] == version) continue;
+            ran = true;
+            seen[i] = version;
+            stats[i].runs++;
+            const PassInfo& pass = passes[pipeline[i]];
+            auto start = std::chrono::steady_clock::now();
+            bool changed = pass.run ? (this->*pass.run)(f, stats[i])
+                                    : run_per_block(pass.run_block, f, clean[i], stats[i]);
+            stats[i].ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (changed) {
+                stats[i].changes++;
+                version++;
             }
         }
-        std::regex assign_const("(\\w+) = (\\d+)");
-        std::smatch m2;
-        if (std::regex_match(line, m2, assign_const)) {
-            const_vals[m2[1]] = std::stoi(m2[2]);
+        if (!ran) break;
+    }
+}
+
+static uint64_t block_hash(const TACInstr* first, const TACInstr* last) {
+    uint64_t h = 1469598103934665603ull;
+    auto mix = [&h](uint64_t v) { h = (h ^ v) * 1099511628211ull; };
+    for (const TACInstr* in = first; in != last; ++in) {
+        mix(static_cast<uint64_t>(in->op));
+        for (const Operand* o : {&in->dst, &in->a, &in->b}) {
+            mix(static_cast<uint64_t>(o->kind) << 32 | static_cast<uint32_t>(o->value));
         }
-        new_code.push_back(line);
+        mix(static_cast<uint32_t>(in->label));
     }
-    return new_code;
+    return h;
 }
 
-std::vector<std::string> Optimizer::algebraic_simplification(const std::vector<std::string>& code) const {
-    std::vector<std::string> new_code;
-    std::regex mul1("(\\w+) = (\\w+) \\* 1");
-    std::regex add0("(\\w+) = (\\w+) \\+ 0");
-    std::regex sub0("(\\w+) = (\\w+) \\- 0");
-    std::regex mul0("(\\w+) = (\\w+) \\* 0");
-    std::regex div1("(\\w+) = (\\w+) / 1");
-    for (auto line : code) {
-        if (is_control_or_label(line)) {
-            new_code.push_back(line);
+// Runs a block-local pass over each basic block. A block whose contents hash
+// to something the pass has already seen without changing it is skipped, so
+// later sweeps only revisit the blocks other passes touched.
+bool Optimizer::run_per_block(BlockPassFn pass, TACFunction& f, std::unordered_set<uint64_t>& clean,
+                              PassStats& stats) const {
+    CFG cfg(f.code);
+    std::vector<TACInstr> new_code;
+    new_code.reserve(f.code.size());
+    std::vector<TACInstr> block;
+    bool changed = false;
+    for (const BasicBlock& b : cfg.blocks) {
+        const TACInstr* first = f.code.data() + b.begin;
+        const TACInstr* last = f.code.data() + b.end;
+        uint64_t h = block_hash(first, last);
+        if (clean.count(h)) {
+            new_code.insert(new_code.end(), first, last);
+            stats.blocks_skipped++;
             continue;
         }
-        line = std::regex_replace(line, mul1, "$1 = $2");
-        line = std::regex_replace(line, add0, "$1 = $2");
-        line = std::regex_replace(line, sub0, "$1 = $2");
-        line = std::regex_replace(line, mul0, "$1 = 0");
-        line = std::regex_replace(line, div1, "$1 = $2");
-        new_code.push_back(line);
+        block.assign(first, last);
+        if ((this->*pass)(f, block)) changed = true;
+        else clean.insert(h);
+        new_code.insert(new_code.end(), block.begin(), block.end());
     }
-    return new_code;
+    f.code.swap(new_code);
+    return changed;
 }
 
-std::vector<std::string> Optimizer::common_subexpression_elimination(const std::vector<std::string>& code) const {
-    std::unordered_map<std::string, std::string> expr_map;
-    std::vector<std::string> new_code;
-    std::regex re("(t\\d+) = (.+)");
-    for (const auto& line : code) {
-        if (is_control_or_label(line)) {
-            new_code.push_back(line);
-            continue;
+// Wegman-Zadeck SCCP over the SSA view: a value is unknown until some
+// executable path assigns it, then a constant, then varying. Only edges out of
+// executable blocks whose branch can go that way are followed, so constants
+// merging at a join with an untaken branch stay constant. Afterwards uses of
+// constant values become literals, decided branches become gotos or vanish,
+// and blocks that never became executable are removed, along with gotos to
+// the label right after them and labels nothing jumps to any more.
+bool Optimizer::sparse_conditional_constant_propagation(TACFunction& f, PassStats&) const {
+    CFG cfg(f.code);
+    if (cfg.size() == 0) return false;
+    DominatorTree dom(cfg);
+    SSA ssa(f, cfg, dom);
+
+    struct Lattice {
+        enum State : unsigned char { UNKNOWN, CONST, VARYING } state;
+        int32_t value;
+        bool operator!=(const Lattice& o) const { return state != o.state || (state == CONST && value != o.value); }
+    };
+    const Lattice unknown{Lattice::UNKNOWN, 0}, varying{Lattice::VARYING, 0};
+    std::vector<Lattice> lattice(ssa.values.size(), unknown);
+    for (size_t v = 0; v < ssa.values.size(); ++v) {
+        if (ssa.values[v].kind == SSA::Value::ENTRY) lattice[v] = varying;
+    }
+
+    // Instructions and phis reading each value.
+    std::vector<std::vector<uint32_t>> instr_users(ssa.values.size()), phi_users(ssa.values.size());
+    for (uint32_t i = 0; i < f.code.size(); ++i) {
+        if (ssa.use_a[i] != SSA::NO_VALUE) instr_users[ssa.use_a[i]].push_back(i);
+        if (ssa.use_b[i] != SSA::NO_VALUE && ssa.use_b[i] != ssa.use_a[i]) instr_users[ssa.use_b[i]].push_back(i);
+    }
+    for (uint32_t p = 0; p < ssa.phis.size(); ++p) {
+        for (ValueId a : ssa.phis[p].args) {
+            if (a != SSA::NO_VALUE) phi_users[a].push_back(p);
         }
-        std::smatch m;
-        if (std::regex_match(line, m, re)) {
-            std::string t = m[1];
-            std::string expr = m[2];
-            if (expr_map.count(expr)) {
-                new_code.push_back(t + " = " + expr_map[expr]);
-            } else {
-                expr_map[expr] = t;
-                new_code.push_back(line);
+    }
+
+    std::vector<char> block_live(cfg.size(), 0);
+    std::vector<std::vector<char>> edge_live(cfg.size());
+    for (BlockId b = 0; b < cfg.size(); ++b) edge_live[b].assign(cfg.blocks[b].preds.size() + (b == 0), 0);
+    std::vector<std::pair<BlockId, BlockId>> flow_work;
+    std::vector<ValueId> value_work;
+    std::vector<BlockId> instr_block(f.code.size());
+    for (BlockId b = 0; b < cfg.size(); ++b) {
+        for (uint32_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; ++i) instr_block[i] = b;
+    }
+
+    auto operand_value = [&](const Operand& o, ValueId v) {
+        if (o.is_const()) return Lattice{Lattice::CONST, o.value};
+        return v == SSA::NO_VALUE ? varying : lattice[v];
+    };
+    auto lower = [&](ValueId v, Lattice l) {
+        if (lattice[v].state == Lattice::VARYING || !(lattice[v] != l)) return;
+        if (lattice[v].state == Lattice::CONST && l.state == Lattice::CONST) l = varying;
+        if (l.state == Lattice::UNKNOWN) return;
+        lattice[v] = l;
+        value_work.push_back(v);
+    };
+    auto mark_edge = [&](BlockId from, BlockId to) {
+        if (to == CFG::NO_BLOCK) return;
+        const std::vector<BlockId>& preds = cfg.blocks[to].preds;
+        for (size_t k = 0; k < preds.size(); ++k) {
+            if (preds[k] == from && !edge_live[to][k]) {
+                edge_live[to][k] = 1;
+                flow_work.push_back(std::make_pair(from, to));
             }
-        } else {
-            new_code.push_back(line);
+        }
+    };
+    auto visit_phi = [&](uint32_t p) {
+        const SSA::Phi& phi = ssa.phis[p];
+        Lattice merged = unknown;
+        for (size_t k = 0; k < phi.args.size(); ++k) {
+            if (!edge_live[phi.block][k]) continue;
+            Lattice a = operand_value(Operand::none(), phi.args[k]);
+            if (a.state == Lattice::UNKNOWN) continue;
+            if (merged.state == Lattice::UNKNOWN) merged = a;
+            else if (merged != a) merged = varying;
+        }
+        lower(phi.value, merged);
+    };
+    auto visit_instr = [&](uint32_t i) {
+        const TACInstr& in = f.code[i];
+        BlockId b = instr_block[i];
+        BlockId next = b + 1 < cfg.size() ? b + 1 : CFG::NO_BLOCK;
+        Lattice a = operand_value(in.a, ssa.use_a[i]);
+        Lattice c = operand_value(in.b, ssa.use_b[i]);
+        if (in.op == TACOp::COPY) {
+            lower(ssa.def[i], a);
+        } else if (is_binary(in.op)) {
+            if (a.state == Lattice::CONST && c.state == Lattice::CONST) {
+                lower(ssa.def[i], Lattice{Lattice::CONST, fold_binary(in.op, a.value, c.value)});
+            } else if (a.state == Lattice::VARYING || c.state == Lattice::VARYING) {
+                lower(ssa.def[i], varying);
+            }
+        } else if (in.has_dst()) {
+            lower(ssa.def[i], varying); // loads and vector ops
+        } else if (in.op == TACOp::GOTO) {
+            mark_edge(b, cfg.block_of_label(in.label));
+        } else if (in.op == TACOp::IF_FALSE) {
+            if (a.state == Lattice::UNKNOWN) return;
+            if (a.state == Lattice::VARYING || a.value != 0) mark_edge(b, next);
+            if (a.state == Lattice::VARYING || a.value == 0) mark_edge(b, cfg.block_of_label(in.label));
+        }
+        bool falls_through = in.op != TACOp::GOTO && in.op != TACOp::IF_FALSE && in.op != TACOp::RETURN;
+        if (i + 1 == cfg.blocks[b].end && falls_through) mark_edge(b, next);
+    };
+
+    edge_live[0].back() = 1;
+    flow_work.push_back(std::make_pair(CFG::NO_BLOCK, BlockId(0)));
+    while (!flow_work.empty() || !value_work.empty()) {
+        while (!flow_work.empty()) {
+            BlockId b = flow_work.back().second;
+            flow_work.pop_back();
+            for (uint32_t p : ssa.block_phis[b]) visit_phi(p);
+            if (block_live[b]) continue;
+            block_live[b] = 1;
+            for (uint32_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; ++i) visit_instr(i);
+        }
+        while (!value_work.empty()) {
+            ValueId v = value_work.back();
+            value_work.pop_back();
+            for (uint32_t p : phi_users[v]) {
+                if (block_live[ssa.phis[p].block]) visit_phi(p);
+            }
+            for (uint32_t i : instr_users[v]) {
+                if (block_live[instr_block[i]]) visit_instr(i);
+            }
+        }
+    }
+
+    std::vector<TACInstr> new_code;
+    new_code.reserve(f.code.size());
+    for (BlockId b = 0; b < cfg.size(); ++b) {
+        if (!block_live[b]) continue;
+        for (uint32_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; ++i) {
+            TACInstr in = f.code[i];
+            Lattice a = operand_value(in.a, ssa.use_a[i]);
+            Lattice c = operand_value(in.b, ssa.use_b[i]);
+            if (a.state == Lattice::CONST) in.a = Operand::constant(a.value);
+            if (c.state == Lattice::CONST) in.b = Operand::constant(c.value);
+            if (is_binary(in.op) && lattice[ssa.def[i]].state == Lattice::CONST) {
+                in = TACInstr::copy(in.dst, Operand::constant(lattice[ssa.def[i]].value));
+            }
+            if (in.op == TACOp::IF_FALSE && in.a.is_const()) {
+                if (in.a.value != 0) continue;
+                in = TACInstr::jump(in.label);
+            }
+            new_code.push_back(in);
+        }
+    }
+
+    std::vector<char> referenced(static_cast<size_t>(f.label_count) + 1, 0);
+    size_t kept = 0;
+    for (size_t i = 0; i < new_code.size(); ++i) {
+        const TACInstr& in = new_code[i];
+        if (in.op == TACOp::GOTO) {
+            size_t j = i + 1;
+            while (j < new_code.size() && new_code[j].op == TACOp::LABEL && new_code[j].label != in.label) ++j;
+            if (j < new_code.size() && new_code[j].op == TACOp::LABEL) continue;
+        }
+        if (in.op == TACOp::GOTO || in.op == TACOp::IF_FALSE) referenced[in.label] = 1;
+        new_code[kept++] = in;
+    }
+    new_code.resize(kept);
+    new_code.erase(std::remove_if(new_code.begin(), new_code.end(), [&](const TACInstr& in) {
+        return in.op == TACOp::LABEL && !referenced[in.label];
+    }), new_code.end());
+    bool changed = new_code != f.code;
+    f.code.swap(new_code);
+    return changed;
+}
+
+bool Optimizer::algebraic_simplification(TACFunction&, std::vector<TACInstr>& code) const {
+    bool changed = false;
+    for (auto& in : code) {
+        if (!is_arith(in.op) || !in.b.is_const()) continue;
+        int32_t b = in.b.value;
+        if ((in.op == TACOp::MUL && b == 1) || (in.op == TACOp::ADD && b == 0) ||
+            (in.op == TACOp::SUB && b == 0) || (in.op == TACOp::DIV && b == 1)) {
+            in = TACInstr::copy(in.dst, in.a);
+            changed = true;
+        } else if (in.op == TACOp::MUL && b == 0) {
+            in = TACInstr::copy(in.dst, Operand::constant(0));
+            changed = true;
         }
     }
-    return new_code;
+    return changed;
 }
 
-std::vector<std::string> Optimizer::advanced_loop_invariant_code_motion(const std::vector<std::string>& code) const {
-    std::vector<std::string> new_code;
-    std::vector<std::string> loop_body;
-    bool in_loop = false;
-    std::regex label_regex("^L\\d+:");
-    std::regex word_re("\\b\\w+\\b");
-    std::size_t last_label_pos = 0;
-    for (std::size_t i = 0; i < code.size(); ++i) {
-        const std::string& line = code[i];
-        if (std::regex_search(line, label_regex)) {
-            in_loop = true;
-            loop_body.clear();
-            last_label_pos = i;
-        } else if (in_loop && line.find("goto") == 0) {
-            // Analyze loop body
-            std::regex assign_re("(\\w+) = (.+)");
-            std::set<std::string> loop_assigned;
-            std::vector<std::pair<std::string, std::string>> assignments;
-            for (const auto& l : loop_body) {
-                std::smatch m;
-                if (std::regex_match(l, m, assign_re)) {
-                    loop_assigned.insert(m[1]);
-                    assignments.push_back({m[1], m[2]});
+// Dominator-scoped value numbering over the SSA view. Expressions are
+// hash-consed on the value numbers of their operands, with commutative
+// operands sorted and GT/GE turned around into LT/LE, so `a + b` and `b + a`
+// meet. A computation whose value is already held by a name that still holds
+// it on every path here becomes a copy of that name, and reads of a name are
+// redirected to the value's first holder, which leaves the copies dead.
+bool Optimizer::global_value_numbering(TACFunction& f, PassStats& stats) const {
+    CFG cfg(f.code);
+    if (cfg.size() == 0) return false;
+    DominatorTree dom(cfg);
+    SSA ssa(f, cfg, dom, false);
+    const uint32_t var_count = static_cast<uint32_t>(f.vars.size());
+    auto name_index = [var_count](const Operand& o) {
+        return o.kind == Operand::VAR ? static_cast<uint32_t>(o.value) : var_count + static_cast<uint32_t>(o.value);
+    };
+    auto name_operand = [var_count](uint32_t n) {
+        return n < var_count ? Operand::var(static_cast<int32_t>(n)) : Operand::temp(static_cast<int32_t>(n - var_count));
+    };
+    auto value_name = [&](ValueId v) {
+        const SSA::Value& val = ssa.values[v];
+        if (val.kind == SSA::Value::INSTR) return name_index(f.code[val.def].dst);
+        if (val.kind == SSA::Value::PHI) return ssa.phis[val.def].name;
+        return val.def;
+    };
+
+    // Operands in a key are a constant or a value number, told apart by the
+    // top bit.
+    typedef std::tuple<TACOp, uint64_t, uint64_t> Key;
+    struct KeyHash {
+        size_t operator()(const Key& k) const {
+            return static_cast<size_t>(std::get<1>(k) * 0x9e3779b97f4a7c15ull ^ std::get<2>(k) * 0xc2b2ae3d27d4eb4full) ^
+                   static_cast<size_t>(std::get<0>(k));
+        }
+    };
+    const uint64_t CONST_BIT = uint64_t(1) << 63;
+    std::vector<ValueId> vn(ssa.values.size(), SSA::NO_VALUE);
+    auto number_of = [&](ValueId v) { return vn[v] == SSA::NO_VALUE ? v : vn[v]; };
+    auto key_operand = [&](const Operand& o, ValueId v) {
+        return o.is_const() ? CONST_BIT | static_cast<uint32_t>(o.value) : static_cast<uint64_t>(number_of(v));
+    };
+
+    std::unordered_map<Key, ValueId, KeyHash> table;       // expression -> value number
+    std::vector<ValueId> leader(ssa.values.size(), SSA::NO_VALUE); // value number -> holding value
+    std::vector<ValueId> current(var_count + static_cast<size_t>(f.temp_count) + 1, SSA::NO_VALUE);
+    for (ValueId v = 0; v < ssa.values.size(); ++v) {
+        if (ssa.values[v].kind == SSA::Value::ENTRY) {
+            current[ssa.values[v].def] = v;
+            leader[v] = v;
+        }
+    }
+    auto holds = [&](ValueId v) { return v != SSA::NO_VALUE && current[value_name(v)] == v; };
+
+    // One log undoes table, leader and current changes when leaving a
+    // dominator subtree.
+    struct Undo {
+        enum Kind : unsigned char { TABLE, LEADER, CURRENT } kind;
+        Key key;
+        uint32_t index;
+        ValueId old;
+    };
+    std::vector<Undo> undo;
+    auto set_current = [&](uint32_t name, ValueId v) {
+        undo.push_back(Undo{Undo::CURRENT, Key(), name, current[name]});
+        current[name] = v;
+    };
+    auto set_leader = [&](ValueId number, ValueId v) {
+        undo.push_back(Undo{Undo::LEADER, Key(), number, leader[number]});
+        leader[number] = v;
+    };
+
+    std::vector<TACInstr> code = f.code;
+    bool changed = false;
+    std::vector<std::pair<BlockId, size_t>> walk;
+    std::vector<size_t> marks;
+    walk.push_back(std::make_pair(BlockId(0), size_t(0)));
+    marks.push_back(0);
+    bool entering = true;
+    while (!walk.empty()) {
+        BlockId b = walk.back().first;
+        if (entering) {
+            for (uint32_t p : ssa.block_phis[b]) {
+                const SSA::Phi& phi = ssa.phis[p];
+                // A phi whose incoming values all share a number is that number.
+                ValueId same = SSA::NO_VALUE;
+                for (ValueId a : phi.args) {
+                    ValueId n = a == SSA::NO_VALUE || vn[a] == SSA::NO_VALUE ? SSA::NO_VALUE : vn[a];
+                    if (n == SSA::NO_VALUE || (same != SSA::NO_VALUE && n != same)) {
+                        same = SSA::NO_VALUE;
+                        break;
+                    }
+                    same = n;
                 }
+                vn[phi.value] = same == SSA::NO_VALUE ? phi.value : same;
+                set_current(phi.name, phi.value);
+                if (!holds(leader[vn[phi.value]])) set_leader(vn[phi.value], phi.value);
             }
-            // Find invariants: assignments whose RHS only uses variables not assigned in the loop or already invariant
-            std::set<std::string> invariants;
-            bool changed = true;
-            while (changed) {
-                changed = false;
-                for (const auto& a : assignments) {
-                    if (invariants.count(a.first)) continue;
-                    bool rhs_invariant = true;
-                    for (std::sregex_iterator it(a.second.begin(), a.second.end(), word_re), end; it != end; ++it) {
-                        std::string v = it->str();
-                        if (loop_assigned.count(v) && !invariants.count(v)) {
-                            rhs_invariant = false;
-                            break;
-                        }
-                    }
-                    if (rhs_invariant) {
-                        invariants.insert(a.first);
+            for (uint32_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; ++i) {
+                TACInstr& in = code[i];
+                for (Operand* o : {&in.a, &in.b}) {
+                    if (!o->is_name()) continue;
+                    ValueId use = o == &in.a ? ssa.use_a[i] : ssa.use_b[i];
+                    ValueId l = leader[number_of(use)];
+                    if (holds(l) && value_name(l) != name_index(*o)) {
+                        *o = name_operand(value_name(l));
                         changed = true;
                     }
                 }
-            }
-            // Move invariant assignments before the loop label
-            std::vector<std::string> invariants_code;
-            for (const auto& l : loop_body) {
-                std::smatch m;
-                if (std::regex_match(l, m, assign_re)) {
-                    if (invariants.count(m[1])) {
-                        invariants_code.push_back(l);
+                if (!in.has_dst()) continue;
+                ValueId d = ssa.def[i];
+                if (in.op == TACOp::COPY && in.a.is_name()) {
+                    vn[d] = number_of(ssa.use_a[i]);
+                } else if (in.op != TACOp::COPY && !is_binary(in.op)) {
+                    vn[d] = d; // loads and vector ops each make a new value
+                } else {
+                    TACOp op = in.op;
+                    uint64_t ka = key_operand(in.a, ssa.use_a[i]);
+                    uint64_t kb = in.op == TACOp::COPY ? 0 : key_operand(in.b, ssa.use_b[i]);
+                    if (op == TACOp::GT || op == TACOp::GE) {
+                        op = op == TACOp::GT ? TACOp::LT : TACOp::LE;
+                        std::swap(ka, kb);
+                    } else if ((op == TACOp::ADD || op == TACOp::MUL || op == TACOp::EQ || op == TACOp::NE) && kb < ka) {
+                        std::swap(ka, kb);
+                    }
+                    Key key(op, ka, kb);
+                    auto it = table.find(key);
+                    if (it != table.end()) {
+                        vn[d] = it->second;
+                        ValueId l = leader[vn[d]];
+                        if (holds(l) && in.op != TACOp::COPY) {
+                            in = TACInstr::copy(in.dst, name_operand(value_name(l)));
+                            stats.eliminated++;
+                            changed = true;
+                        }
+                    } else {
+                        vn[d] = d;
+                        undo.push_back(Undo{Undo::TABLE, key, 0, SSA::NO_VALUE});
+                        table.emplace(key, d);
                     }
                 }
+                set_current(name_index(in.dst), d);
+                if (!holds(leader[vn[d]])) set_leader(vn[d], d);
             }
-            for (const auto& inv : invariants_code) {
-                new_code.push_back(inv);
-            }
-            // Add rest of loop body
-            for (const auto& l : loop_body) {
-                std::smatch m;
-                if (std::regex_match(l, m, assign_re)) {
-                    if (invariants.count(m[1])) continue;
-                }
-                new_code.push_back(l);
-            }
-            new_code.push_back(line);
-            in_loop = false;
-        } else if (in_loop) {
-            loop_body.push_back(line);
+        }
+        size_t& next = walk.back().second;
+        if (next < dom.children[b].size()) {
+            BlockId c = dom.children[b][next++];
+            walk.push_back(std::make_pair(c, size_t(0)));
+            marks.push_back(undo.size());
+            entering = true;
         } else {
-            new_code.push_back(line);
+            for (size_t k = undo.size(); k-- > marks.back();) {
+                const Undo& u = undo[k];
+                if (u.kind == Undo::TABLE) table.erase(u.key);
+                else if (u.kind == Undo::LEADER) leader[u.index] = u.old;
+                else current[u.index] = u.old;
+            }
+            undo.resize(marks.back());
+            marks.pop_back();
+            walk.pop_back();
+            entering = false;
         }
     }
-    return new_code;
+    if (changed) f.code.swap(code);
+    return changed;
 }
 
-std::vector<std::string> Optimizer::remove_useless_assignments(const std::vector<std::string>& code) const {
-    std::vector<std::string> new_code;
-    std::regex assign_re("(\w+) = (.+)");
-    for (size_t i = 0; i < code.size(); ++i) {
-        std::smatch m1, m2;
-        if (i + 1 < code.size() &&
-            std::regex_match(code[i], m1, assign_re) &&
-            std::regex_match(code[i+1], m2, assign_re) &&
-            m1[1] == m2[1]) {
-            // Assignment is immediately overwritten, skip the first
-            continue;
+// Moves loop-invariant assignments into the preheader of their innermost
+// loop. An assignment is invariant when its operands are constants, names not
+// assigned anywhere in the loop, or names whose only assignment in the loop is
+// itself invariant; loads stay, since the loop may store to their array. It may
+// move when its target has no other assignment in the loop, is not live into
+// the header (no read sees the value from before the loop) and, unless its
+// block dominates every exit, is not live after the loop either. A temporary
+// that never lives across blocks, as the generator reuses them, is judged per
+// assignment instead: each one is read only in its own block, so a hoisted one
+// takes a fresh temporary for itself and its readers, whatever else the loop
+// assigns to the name. Code hoisted out of an inner loop lands in a block of
+// the enclosing loop, so the next run can carry it further out. A loop without
+// a preheader gets a new labelled block in front of its header, which jumps
+// from outside the loop are redirected to.
+bool Optimizer::loop_invariant_code_motion(TACFunction& f, PassStats&) const {
+    CFG cfg(f.code);
+    if (cfg.size() == 0) return false;
+    DominatorTree dom(cfg);
+    LoopForest forest(cfg, dom);
+    if (forest.loops.empty()) return false;
+    Liveness liveness(f, cfg);
+    auto live_into = [&](BlockId b, const Operand& o) {
+        uint32_t s = liveness.slot(liveness.index(o));
+        return s != Liveness::NO_SLOT && liveness.live_in[b].test(s);
+    };
+
+    // A preheader ending in an ifFalse whose target is the header reaches it
+    // both ways, so code placed in it would be skipped by the jump.
+    for (auto& loop : forest.loops) {
+        if (loop.preheader != CFG::NO_BLOCK && f.code[cfg.blocks[loop.preheader].end - 1].op == TACOp::IF_FALSE) {
+            loop.preheader = CFG::NO_BLOCK;
         }
-        new_code.push_back(code[i]);
     }
-    return new_code;
-}
 
-std::vector<std::string> Optimizer::strength_reduction(const std::vector<std::string>& code) const {
-    std::vector<std::string> new_code;
-    std::regex mul2("(\\w+) = (\\w+) \\* 2");
-    std::regex mul4("(\\w+) = (\\w+) \\* 4");
-    for (const auto& line : code) {
-        if (is_control_or_label(line)) {
-            new_code.push_back(line);
-            continue;
+    // The assignment each read of a block-local temporary sees.
+    const uint32_t NONE = UINT32_MAX;
+    auto local = [&](const Operand& o) { return o.kind == Operand::TEMP && liveness.slot(liveness.index(o)) == Liveness::NO_SLOT; };
+    std::vector<uint32_t> reach_a(f.code.size(), NONE), reach_b(f.code.size(), NONE);
+    std::vector<uint32_t> last_def(liveness.universe(), NONE);
+    for (const BasicBlock& bb : cfg.blocks) {
+        for (uint32_t i = bb.begin; i < bb.end; ++i) {
+            const TACInstr& in = f.code[i];
+            if (local(in.a)) reach_a[i] = last_def[liveness.index(in.a)];
+            if (local(in.b)) reach_b[i] = last_def[liveness.index(in.b)];
+            if (in.has_dst()) last_def[liveness.index(in.dst)] = i;
         }
-        std::smatch m;
-        if (std::regex_match(line, m, mul2)) {
-            std::string x = m[1];
-            std::string y = m[2];
-            new_code.push_back(x + " = " + y + " + " + y);
-        } else if (std::regex_match(line, m, mul4)) {
-            std::string x = m[1];
-            std::string y = m[2];
-            new_code.push_back(x + " = " + y + " + " + y + " + " + y + " + " + y);
-        } else {
-            new_code.push_back(line);
+        for (uint32_t i = bb.begin; i < bb.end; ++i) {
+            if (f.code[i].has_dst()) last_def[liveness.index(f.code[i].dst)] = NONE;
         }
     }
-    return new_code;
-}
 
-std::vector<std::string> Optimizer::induction_variable_simplification(const std::vector<std::string>& code) const {
-    std::vector<std::string> new_code;
-    std::regex inc_re("(\\w+) = (\\w+) \\+ 1");
-    std::set<std::string> used;
-    // Find all used variables
-    std::regex word_re("\\b\\w+\\b");
-    for (const auto& line : code) {
-        for (std::sregex_iterator it(line.begin(), line.end(), word_re), end; it != end; ++it) {
-            used.insert(it->str());
+    std::vector<char> hoisted(f.code.size(), 0);
+    std::vector<std::vector<uint32_t>> hoist(forest.loops.size()); // per loop, in dependency order
+    std::vector<uint32_t> renamed;                                // hoisted that need a fresh temporary
+    std::vector<int> defs(liveness.universe(), 0);                // assignments per name in the loop
+    std::vector<char> invariant(liveness.universe(), 0);          // name's one assignment is invariant
+    std::vector<size_t> touched;
+    for (size_t l = 0; l < forest.loops.size(); ++l) {
+        const Loop& loop = forest.loops[l];
+        // A loop whose header falls through from a block inside it cannot
+        // get a preheader placed in front of the header.
+        if (loop.preheader == CFG::NO_BLOCK && loop.header > 0 && forest.contains(static_cast<int>(l), loop.header - 1)) {
+            const TACInstr& before = f.code[cfg.blocks[loop.header - 1].end - 1];
+            if (before.op != TACOp::GOTO && before.op != TACOp::RETURN) continue;
         }
-    }
-    for (size_t i = 0; i < code.size(); ++i) {
-        std::smatch m;
-        if (std::regex_match(code[i], m, inc_re)) {
-            std::string t = m[1];
-            // If t is only used for incrementing i, skip it
-            bool only_for_inc = true;
-            for (size_t j = i + 1; j < code.size(); ++j) {
-                if (code[j].find(t) != std::string::npos && code[j].find("i = " + t) == std::string::npos) {
-                    only_for_inc = false;
-                    break;
+        for (BlockId b : loop.blocks) {
+            for (uint32_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; ++i) {
+                if (!f.code[i].has_dst()) continue;
+                size_t d = liveness.index(f.code[i].dst);
+                if (defs[d]++ == 0) touched.push_back(d);
+            }
+        }
+        std::vector<BlockId> exits;
+        std::vector<BlockId> exiting;
+        for (BlockId b : loop.blocks) {
+            for (BlockId s : cfg.blocks[b].succs) {
+                if (forest.contains(static_cast<int>(l), s)) continue;
+                exits.push_back(s);
+                if (exiting.empty() || exiting.back() != b) exiting.push_back(b);
+            }
+        }
+        auto operand_invariant = [&](const Operand& o, uint32_t reach) {
+            if (!o.is_name()) return true;
+            if (reach != NONE) return hoisted[reach] != 0;
+            size_t n = liveness.index(o);
+            return defs[n] == 0 || invariant[n];
+        };
+        bool grew = true;
+        while (grew) {
+            grew = false;
+            for (BlockId b : loop.blocks) {
+                if (forest.loop_of[b] != static_cast<int>(l)) continue;
+                for (uint32_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; ++i) {
+                    const TACInstr& in = f.code[i];
+                    if (hoisted[i] || !in.has_dst() || is_memory(in.op)) continue;
+                    size_t d = liveness.index(in.dst);
+                    if (!operand_invariant(in.a, reach_a[i]) || !operand_invariant(in.b, reach_b[i])) continue;
+                    if (!local(in.dst)) {
+                        if (defs[d] != 1 || in.a == in.dst || in.b == in.dst) continue;
+                        if (live_into(loop.header, in.dst)) continue;
+                        bool covers_exits = true;
+                        for (BlockId e : exiting) covers_exits = covers_exits && dom.dominates(b, e);
+                        bool live_after = false;
+                        for (BlockId e : exits) live_after = live_after || live_into(e, in.dst);
+                        if (live_after && !covers_exits) continue;
+                    }
+                    hoisted[i] = 1;
+                    invariant[d] = 1;
+                    hoist[l].push_back(i);
+                    if (local(in.dst) && defs[d] > 1) renamed.push_back(i);
+                    grew = true;
                 }
             }
-            if (only_for_inc) continue;
         }
-        new_code.push_back(code[i]);
+        for (size_t n : touched) {
+            defs[n] = 0;
+            invariant[n] = 0;
+        }
+        touched.clear();
     }
-    return new_code;
-}
 
-std::vector<std::string> Optimizer::loop_unrolling(const std::vector<std::string>& code) const {
-    std::vector<std::string> new_code;
-    std::regex loop_start("(\\w+) = 0");
-    std::regex loop_cond("(\\w+) = (\\w+) LT (\\d+)");
-    std::regex inc_re("(\\w+) = (\\w+) \\+ 1");
-    for (size_t i = 0; i < code.size(); ++i) {
-        if (i + 7 < code.size() &&
-            std::regex_match(code[i], loop_start) &&
-            std::regex_match(code[i+2], loop_cond) &&
-            std::regex_match(code[i+8], inc_re)) {
-            // Try to unroll
-            std::smatch m_start, m_cond, m_inc;
-            std::regex_match(code[i], m_start, loop_start);
-            std::regex_match(code[i+2], m_cond, loop_cond);
-            std::regex_match(code[i+8], m_inc, inc_re);
-            std::string var = m_start[1];
-            int limit = std::stoi(m_cond[3]);
-            // Unroll only if limit is small
-            if (limit <= 8) {
-                // Copy code before loop
-                for (size_t k = 0; k < i; ++k) new_code.push_back(code[k]);
-                // Unroll loop body
-                for (int iter = 0; iter < limit; ++iter) {
-                    for (size_t k = i + 4; k < i + 8; ++k) {
-                        std::string body_line = code[k];
-                        // Replace i with iter
-                        size_t pos = 0;
-                        while ((pos = body_line.find(var, pos)) != std::string::npos) {
-                            if ((pos == 0 || !isalnum(body_line[pos-1])) && (pos + var.size() == body_line.size() || !isalnum(body_line[pos+var.size()]))) {
-                                body_line.replace(pos, var.size(), std::to_string(iter));
-                                pos += std::to_string(iter).size();
-                            } else {
-                                pos += var.size();
-                            }
-                        }
-                        new_code.push_back(body_line);
-                    }
-                }
-                // Skip the original loop
-                i += 8;
-                continue;
+    std::vector<Operand> fresh(f.code.size(), Operand::none());
+    for (uint32_t i : renamed) fresh[i] = f.code[i].dst = f.new_temp();
+    if (!renamed.empty()) {
+        for (uint32_t i = 0; i < f.code.size(); ++i) {
+            if (reach_a[i] != NONE && fresh[reach_a[i]].kind != Operand::NONE) f.code[i].a = fresh[reach_a[i]];
+            if (reach_b[i] != NONE && fresh[reach_b[i]].kind != Operand::NONE) f.code[i].b = fresh[reach_b[i]];
+        }
+    }
+
+    // Where each loop's hoisted code goes: before the preheader's goto, at
+    // the end of a preheader that falls into the header, or into a new block.
+    std::vector<std::vector<TACInstr>> insert_before(f.code.size() + 1);
+    std::unordered_map<int32_t, int32_t> retarget; // header label -> new preheader label
+    std::vector<int> new_header_of(cfg.size(), -1);
+    bool changed = false;
+    for (size_t l = 0; l < forest.loops.size(); ++l) {
+        if (hoist[l].empty()) continue;
+        const Loop& loop = forest.loops[l];
+        std::vector<TACInstr>* dest;
+        if (loop.preheader != CFG::NO_BLOCK) {
+            const BasicBlock& pre = cfg.blocks[loop.preheader];
+            bool jumps = f.code[pre.end - 1].op == TACOp::GOTO;
+            dest = &insert_before[jumps ? pre.end - 1 : pre.end];
+        } else {
+            dest = &insert_before[cfg.blocks[loop.header].begin];
+            int32_t label = f.new_label();
+            retarget[f.code[cfg.blocks[loop.header].begin].label] = label;
+            new_header_of[loop.header] = static_cast<int>(l);
+            dest->push_back(TACInstr::label_def(label));
+        }
+        for (uint32_t i : hoist[l]) dest->push_back(f.code[i]);
+        changed = true;
+    }
+    if (!changed) return false;
+
+    std::vector<TACInstr> new_code;
+    new_code.reserve(f.code.size() + 1);
+    for (BlockId b = 0; b < cfg.size(); ++b) {
+        for (uint32_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; ++i) {
+            new_code.insert(new_code.end(), insert_before[i].begin(), insert_before[i].end());
+            if (hoisted[i]) continue;
+            TACInstr in = f.code[i];
+            if ((in.op == TACOp::GOTO || in.op == TACOp::IF_FALSE) && retarget.count(in.label)) {
+                BlockId target = cfg.block_of_label(in.label);
+                int l = new_header_of[target];
+                if (l >= 0 && !forest.contains(l, b)) in.label = retarget[in.label];
             }
+            new_code.push_back(in);
         }
-        new_code.push_back(code[i]);
     }
-    return new_code;
+    new_code.insert(new_code.end(), insert_before[f.code.size()].begin(), insert_before[f.code.size()].end());
+    f.code.swap(new_code);
+    return true;
 }
 
-std::vector<std::string> Optimizer::remove_redundant_copies(const std::vector<std::string>& code) const {
-    std::vector<std::string> new_code;
-    std::regex assign_re("(\\w+) = (\\w+)");
-    for (size_t i = 0; i + 1 < code.size(); ++i) {
-        std::smatch m1, m2;
-        if (std::regex_match(code[i], m1, assign_re) &&
-            std::regex_match(code[i+1], m2, assign_re)) {
-            std::string lhs1 = m1[1], rhs1 = m1[2];
-            std::string lhs2 = m2[1], rhs2 = m2[2];
-            if (lhs2 == rhs1 && rhs2 == lhs1) {
-                // t4 = constant; constant = t4 pattern, remove both
-                ++i; // skip next line too
+bool Optimizer::remove_useless_assignments(TACFunction&, std::vector<TACInstr>& code) const {
+    std::vector<TACInstr> new_code;
+    new_code.reserve(code.size());
+    for (size_t i = 0; i < code.size(); ++i) {
+        const TACInstr& cur = code[i];
+        if (i + 1 < code.size() && cur.has_dst()) {
+            const TACInstr& next = code[i + 1];
+            if (next.has_dst() && next.dst == cur.dst && next.a != cur.dst && next.b != cur.dst) {
+                // Assignment is immediately overwritten, skip the first
                 continue;
             }
         }
-        new_code.push_back(code[i]);
-    }
-    // Add last line if not handled
-    if (!code.empty() && (new_code.empty() || new_code.back() != code.back())) {
-        new_code.push_back(code.back());
+        new_code.push_back(cur);
     }
-    return new_code;
+    bool changed = new_code.size() != code.size();
+    code.swap(new_code);
+    return changed;
 }
 
-std::vector<std::string> Optimizer::constant_propagation_and_folding(const std::vector<std::string>& code) const {
-    std::unordered_map<std::string, int> consts;
-    std::vector<std::string> new_code;
-    std::regex assign_const("(\\w+) = (\\d+)");
-    std::regex binop("(\\w+) = (\\w+) ([-+*/]) (\\w+)");
-    for (const auto& line : code) {
-        std::smatch m;
-        if (std::regex_match(line, m, assign_const)) {
-            consts[m[1]] = std::stoi(m[2]);
-            new_code.push_back(line);
-        } else if (std::regex_match(line, m, binop)) {
-            std::string lhs = m[1];
-            std::string v1 = m[2];
-            std::string op = m[3];
-            std::string v2 = m[4];
-            if (consts.count(v1) && consts.count(v2)) {
-                int a = consts[v1];
-                int b = consts[v2];
-                int v = 0;
-                if (op == "+") v = a + b;
-                else if (op == "-") v = a - b;
-                else if (op == "*") v = a * b;
-                else if (op == "/") v = (b != 0) ? a / b : 0;
-                new_code.push_back(lhs + " = " + std::to_string(v));
-                consts[lhs] = v;
+// Multiplications by a power of two become left shifts. Signed division
+// rounds toward zero while an arithmetic shift rounds down, so a division by
+// 2^k first adds 2^k - 1 to a negative dividend: with s = x >> 31 (0 or -1),
+// that bias is s - (s << k), or -s when k is 1.
+bool Optimizer::strength_reduction(TACFunction& f, std::vector<TACInstr>& code) const {
+    auto log2_of = [](const Operand& o) {
+        uint32_t v = static_cast<uint32_t>(o.value);
+        if (!o.is_const() || v < 2 || (v & (v - 1)) != 0) return -1;
+        int k = 0;
+        while (v >>= 1) ++k;
+        return k;
+    };
+    std::vector<TACInstr> new_code;
+    new_code.reserve(code.size());
+    bool changed = false;
+    for (const auto& in : code) {
+        int k = in.op == TACOp::MUL ? log2_of(in.b) : -1;
+        int k_left = in.op == TACOp::MUL ? log2_of(in.a) : -1;
+        int k_div = in.op == TACOp::DIV && in.a.is_name() && in.b.value > 0 ? log2_of(in.b) : -1;
+        if (k > 0 || k_left > 0) {
+            const Operand& x = k > 0 ? in.a : in.b;
+            new_code.push_back(TACInstr::binary(TACOp::SHL, in.dst, x, Operand::constant(k > 0 ? k : k_left)));
+            changed = true;
+        } else if (k_div > 0) {
+            Operand sign = f.new_temp();
+            Operand biased = f.new_temp();
+            new_code.push_back(TACInstr::binary(TACOp::SHR, sign, in.a, Operand::constant(31)));
+            if (k_div == 1) {
+                new_code.push_back(TACInstr::binary(TACOp::SUB, biased, in.a, sign));
             } else {
-                new_code.push_back(line);
-                consts.erase(lhs);
+                Operand high = f.new_temp();
+                Operand bias = f.new_temp();
+                new_code.push_back(TACInstr::binary(TACOp::SHL, high, sign, Operand::constant(k_div)));
+                new_code.push_back(TACInstr::binary(TACOp::SUB, bias, sign, high));
+                new_code.push_back(TACInstr::binary(TACOp::ADD, biased, in.a, bias));
             }
+            new_code.push_back(TACInstr::binary(TACOp::SHR, in.dst, biased, Operand::constant(k_div)));
+            changed = true;
         } else {
-            new_code.push_back(line);
+            new_code.push_back(in);
         }
     }
-    return new_code;
+    code.swap(new_code);
+    return changed;
 }
 
-std::vector<std::string> Optimizer::induction_variable_elimination(const std::vector<std::string>& code) const {
-    std::vector<std::string> new_code;
-    std::regex inc_re("(\\w+) = (\\w+) \\+ 1");
-    std::set<std::string> used;
-    // Find all used variables
-    std::regex word_re("\\b\\w+\\b");
-    for (const auto& line : code) {
-        for (std::sregex_iterator it(line.begin(), line.end(), word_re), end; it != end; ++it) {
-            used.insert(it->str());
+// Strength reduction over each loop's induction variables. Every product
+// var * c (or var << k) of a basic induction variable gets a temporary that
+// holds it throughout the loop: computed once in the preheader and bumped by
+// step * c right after each update of var, so the product becomes a copy.
+// When var is then only read by its own updates and the loop test, and is
+// dead after the loop, the test is rewritten against the temporary
+// (var < n becomes var*c < n*c, for c > 0 and a range of var known not to
+// overflow), which leaves var's updates to dead code elimination.
+bool Optimizer::induction_variable_strength_reduction(TACFunction& f, PassStats&) const {
+    CFG cfg(f.code);
+    if (cfg.size() == 0) return false;
+    DominatorTree dom(cfg);
+    LoopForest forest(cfg, dom);
+    if (forest.loops.empty()) return false;
+    InductionVariables ivs(f, cfg, forest);
+    bool any = false;
+    for (const auto& d : ivs.derived) any = any || !d.empty();
+    if (!any) return false;
+    Liveness liveness(f, cfg);
+
+    std::vector<TACInstr> code = f.code;
+    std::vector<std::vector<TACInstr>> insert_before(f.code.size() + 1);
+    std::vector<std::vector<TACInstr>> insert_after(f.code.size());
+    std::vector<char> rewritten(f.code.size(), 0);
+    bool changed = false;
+    for (size_t l = 0; l < forest.loops.size(); ++l) {
+        const Loop& loop = forest.loops[l];
+        if (loop.preheader == CFG::NO_BLOCK || ivs.derived[l].empty()) continue;
+        const BasicBlock& pre = cfg.blocks[loop.preheader];
+        TACOp pre_last = f.code[pre.end - 1].op;
+        if (pre_last == TACOp::IF_FALSE || pre_last == TACOp::RETURN) continue;
+        std::vector<TACInstr>& entry = insert_before[pre_last == TACOp::GOTO ? pre.end - 1 : pre.end];
+
+        std::map<std::pair<size_t, int32_t>, Operand> reduced; // (basic IV, scale) -> temporary
+        for (const DerivedIV& d : ivs.derived[l]) {
+            const BasicIV& iv = ivs.basic[l][d.basic];
+            auto it = reduced.find({d.basic, d.scale});
+            if (it == reduced.end()) {
+                Operand t = f.new_temp();
+                it = reduced.insert({{d.basic, d.scale}, t}).first;
+                entry.push_back(TACInstr::binary(TACOp::MUL, t, iv.var, Operand::constant(d.scale)));
+                for (size_t u = 0; u < iv.updates.size(); ++u) {
+                    int32_t bump = fold_binary(TACOp::MUL, iv.steps[u], d.scale);
+                    insert_after[iv.updates[u]].push_back(TACInstr::binary(TACOp::ADD, t, t, Operand::constant(bump)));
+                }
+            }
+            code[d.instr] = TACInstr::copy(code[d.instr].dst, it->second);
+            rewritten[d.instr] = 1;
+            changed = true;
         }
-    }
-    for (size_t i = 0; i < code.size(); ++i) {
-        std::smatch m;
-        if (std::regex_match(code[i], m, inc_re)) {
-            std::string t = m[1];
-            // If t is only used for incrementing i, skip it
-            bool only_for_inc = true;
-            for (size_t j = i + 1; j < code.size(); ++j) {
-                if (code[j].find(t) != std::string::npos && code[j].find("i = " + t) == std::string::npos) {
-                    only_for_inc = false;
-                    break;
+
+        // Linear function test replacement on the header's exit test.
+        const BasicBlock& hb = cfg.blocks[loop.header];
+        const TACInstr& test = f.code[hb.end - 1];
+        if (test.op != TACOp::IF_FALSE || !test.a.is_name()) continue;
+        uint32_t cond = UINT32_MAX;
+        for (uint32_t i = hb.begin; i + 1 < hb.end; ++i) {
+            if (f.code[i].has_dst() && f.code[i].dst == test.a) cond = i;
+        }
+        if (cond == UINT32_MAX || !is_relational(f.code[cond].op) || rewritten[cond]) continue;
+        TACOp rel = f.code[cond].op;
+        Operand var = f.code[cond].a;
+        int64_t bound;
+        if (var.is_name() && f.code[cond].b.is_const()) {
+            bound = f.code[cond].b.value;
+        } else if (f.code[cond].b.is_name() && f.code[cond].a.is_const()) {
+            var = f.code[cond].b;
+            bound = f.code[cond].a.value;
+            rel = rel == TACOp::LT ? TACOp::GT : rel == TACOp::GT ? TACOp::LT
+                : rel == TACOp::LE ? TACOp::GE : rel == TACOp::GE ? TACOp::LE : rel;
+        } else {
+            continue;
+        }
+        if (rel == TACOp::EQ || rel == TACOp::NE) continue;
+        const BasicIV* iv = ivs.find(static_cast<int>(l), var);
+        if (!iv || !iv->start_known) continue;
+        size_t basic = static_cast<size_t>(iv - ivs.basic[l].data());
+        auto best = reduced.end();
+        for (auto it = reduced.begin(); it != reduced.end(); ++it) {
+            if (it->first.first == basic && it->first.second > 0) best = it;
+        }
+        if (best == reduced.end()) continue;
+        int64_t scale = best->first.second;
+
+        // var's values while the loop runs stay within [lo, hi].
+        bool upward = rel == TACOp::LT || rel == TACOp::LE;
+        int64_t reach = 0;
+        bool monotonic = true;
+        for (int32_t step : iv->steps) {
+            monotonic = monotonic && step != 0 && (step > 0) == upward;
+            reach += step;
+        }
+        if (!monotonic) continue;
+        int64_t lo = upward ? iv->start : std::min<int64_t>(iv->start, bound) + reach;
+        int64_t hi = upward ? std::max<int64_t>(iv->start, bound) + reach : iv->start;
+        auto fits = [](int64_t v) { return v >= INT32_MIN && v <= INT32_MAX; };
+        if (!fits(lo * scale) || !fits(hi * scale) || !fits(bound * scale)) continue;
+
+        // var must have no reader left but its updates and the test.
+        std::set<uint32_t> own(iv->updates.begin(), iv->updates.end());
+        own.insert(cond);
+        for (uint32_t u : iv->updates) {
+            if (f.code[u].op == TACOp::COPY) {
+                for (uint32_t i = u; i-- > 0;) {
+                    if (f.code[i].dst == f.code[u].a) {
+                        own.insert(i);
+                        break;
+                    }
+                }
+            }
+        }
+        bool only_test = true;
+        for (BlockId b : loop.blocks) {
+            for (uint32_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end && only_test; ++i) {
+                if (own.count(i) || rewritten[i]) continue;
+                only_test = code[i].a != var && code[i].b != var;
+            }
+        }
+        uint32_t s = liveness.slot(liveness.index(var));
+        for (BlockId b : loop.blocks) {
+            for (BlockId e : cfg.blocks[b].succs) {
+                if (!forest.contains(static_cast<int>(l), e) && s != Liveness::NO_SLOT && liveness.live_in[e].test(s)) {
+                    only_test = false;
                 }
             }
-            if (only_for_inc) continue;
         }
+        if (!only_test) continue;
+        code[cond] = TACInstr::binary(rel, f.code[cond].dst, best->second,
+                                      Operand::constant(static_cast<int32_t>(bound * scale)));
+        rewritten[cond] = 1;
+    }
+    if (!changed) return false;
+
+    std::vector<TACInstr> new_code;
+    new_code.reserve(code.size() + 8);
+    for (uint32_t i = 0; i < code.size(); ++i) {
+        new_code.insert(new_code.end(), insert_before[i].begin(), insert_before[i].end());
         new_code.push_back(code[i]);
+        new_code.insert(new_code.end(), insert_after[i].begin(), insert_after[i].end());
     }
-    return new_code;
+    new_code.insert(new_code.end(), insert_before[code.size()].begin(), insert_before[code.size()].end());
+    f.code.swap(new_code);
+    return true;
 }
 
-std::vector<std::string> Optimizer::full_dead_code_elimination(const std::vector<std::string>& code) const {
-    std::vector<std::string> new_code;
-    std::regex assign_re("(\\w+) = (.+)");
-    std::set<std::string> used;
-    // First pass: collect all used variables (on RHS, in control flow, etc.)
-    for (const auto& line : code) {
-        if (line.empty() || line.back() == ':' || line.find("goto") == 0 || line.find("ifFalse") == 0 || line.find("return") == 0) {
-            std::regex word_re("\\b\\w+\\b");
-            for (std::sregex_iterator it(line.begin(), line.end(), word_re), end; it != end; ++it) {
-                used.insert(it->str());
+// Unrolls innermost loops shaped like the generated while loops: a header
+// that tests `i REL n` against a constant and branches out, a body laid out
+// after it, and one latch jumping back. i must be assigned exactly once per
+// iteration, as i = i +/- step (possibly through a temporary). When i's
+// starting constant is known the trip count is exact: a loop whose copies fit
+// the size budget is replaced by straight-line copies, and otherwise a loop
+// running unroll_factor copies per test is followed by a straight-line
+// epilogue for the leftover iterations. With an unknown start the original
+// loop is kept as the remainder loop behind the unrolled one.
+bool Optimizer::loop_unrolling(TACFunction& f, PassStats&) const {
+    CFG cfg(f.code);
+    if (cfg.size() == 0) return false;
+    DominatorTree dom(cfg);
+    LoopForest forest(cfg, dom);
+    InductionVariables ivs(f, cfg, forest);
+    const int factor = options.unroll_factor;
+    const int64_t budget = options.unroll_budget;
+
+    struct Rewrite {
+        uint32_t begin, end;            // replaced code range
+        std::vector<TACInstr> code;
+    };
+    std::vector<Rewrite> rewrites;
+    std::unordered_map<int32_t, std::vector<uint32_t>> jumps_to; // label -> jumps targeting it
+    for (uint32_t i = 0; i < f.code.size(); ++i) {
+        if (f.code[i].op == TACOp::GOTO || f.code[i].op == TACOp::IF_FALSE) jumps_to[f.code[i].label].push_back(i);
+    }
+    for (const Loop& loop : forest.loops) {
+        if (!loop.children.empty() || loop.latches.size() != 1) continue;
+        BlockId h = loop.header, latch = loop.latches[0];
+        if (loop.blocks.size() != latch - h + 1 || loop.blocks.back() != latch) continue;
+        const BasicBlock& hb = cfg.blocks[h];
+        const TACInstr& head_label = f.code[hb.begin];
+        const TACInstr& test = f.code[hb.end - 1];
+        const TACInstr& back = f.code[cfg.blocks[latch].end - 1];
+        if (head_label.op != TACOp::LABEL || test.op != TACOp::IF_FALSE || !test.a.is_name()) continue;
+        if (back.op != TACOp::GOTO || back.label != head_label.label || latch == h) continue;
+        if (std::find(f.unrolled.begin(), f.unrolled.end(), head_label.label) != f.unrolled.end()) continue;
+        // A vectorized loop's scalar epilogue runs fewer than vector_width times.
+        if (std::find(f.vectorized.begin(), f.vectorized.end(), head_label.label) != f.vectorized.end()) continue;
+        BlockId exit = cfg.block_of_label(test.label);
+        if (exit == CFG::NO_BLOCK || forest.contains(static_cast<int>(&loop - forest.loops.data()), exit)) continue;
+        uint32_t first = hb.begin, last = cfg.blocks[latch].end; // [first, last) is the loop
+
+        // Only the header may leave the loop, only the latch may jump back,
+        // and labels inside the body must not be reached from outside.
+        bool shaped = true;
+        std::unordered_map<int32_t, int32_t> body_labels;
+        for (uint32_t i = hb.end; i < last && shaped; ++i) {
+            const TACInstr& in = f.code[i];
+            if (in.op == TACOp::LABEL) body_labels[in.label] = 0;
+            if (in.op == TACOp::RETURN) shaped = false;
+            if ((in.op == TACOp::GOTO || in.op == TACOp::IF_FALSE) && i + 1 != last) {
+                BlockId t = cfg.block_of_label(in.label);
+                if (t == CFG::NO_BLOCK || t <= h || t > latch) shaped = false;
             }
+        }
+        for (const auto& l : body_labels) {
+            for (uint32_t i : jumps_to[l.first]) shaped = shaped && i >= first && i < last;
+        }
+        if (!shaped) continue;
+
+        // The exit test: cond = i REL n (or n REL i), computed in the header.
+        const TACInstr* cond = nullptr;
+        for (uint32_t i = hb.begin; i + 1 < hb.end; ++i) {
+            if (f.code[i].has_dst() && f.code[i].dst == test.a) cond = &f.code[i];
+        }
+        if (!cond || !is_relational(cond->op)) continue;
+        TACOp rel = cond->op;
+        Operand iv = cond->a;
+        int64_t bound;
+        if (cond->a.is_name() && cond->b.is_const()) {
+            bound = cond->b.value;
+        } else if (cond->b.is_name() && cond->a.is_const()) {
+            iv = cond->b;
+            bound = cond->a.value;
+            if (rel == TACOp::LT) rel = TACOp::GT;
+            else if (rel == TACOp::GT) rel = TACOp::LT;
+            else if (rel == TACOp::LE) rel = TACOp::GE;
+            else if (rel == TACOp::GE) rel = TACOp::LE;
+        } else {
             continue;
         }
-        std::smatch m;
-        if (std::regex_match(line, m, assign_re)) {
-            std::string expr = m[2];
-            std::regex word_re("\\b\\w+\\b");
-            for (std::sregex_iterator it(expr.begin(), expr.end(), word_re), end; it != end; ++it) {
-                used.insert(it->str());
+        if (rel == TACOp::EQ || rel == TACOp::NE) continue;
+
+        // i must be a basic induction variable with a single update, in a
+        // block run on every iteration.
+        const BasicIV* basic = ivs.find(static_cast<int>(&loop - forest.loops.data()), iv);
+        if (!basic || basic->updates.size() != 1) continue;
+        BlockId update_block = h;
+        while (cfg.blocks[update_block].end <= basic->updates[0]) ++update_block;
+        if (!dom.dominates(update_block, latch)) continue;
+        int64_t step = basic->steps[0];
+        bool upward = rel == TACOp::LT || rel == TACOp::LE;
+        if (step == 0 || (step > 0) != upward) continue;
+        bool start_known = basic->start_known;
+        int64_t start = basic->start;
+        int64_t trips = -1;
+        if (start_known) {
+            int64_t span = rel == TACOp::LT ? bound - start : rel == TACOp::LE ? bound - start + 1
+                         : rel == TACOp::GT ? start - bound : start - bound + 1;
+            int64_t by = step > 0 ? step : -step;
+            trips = span <= 0 ? 0 : (span + by - 1) / by;
+            int64_t final_value = start + trips * step;
+            if (final_value < INT32_MIN || final_value > INT32_MAX) continue;
+        }
+
+        // One iteration is the header without its label and test, then the
+        // body without the back jump; body labels get fresh numbers per copy.
+        std::vector<TACInstr> head(f.code.begin() + first + 1, f.code.begin() + hb.end - 1);
+        std::vector<TACInstr> body(f.code.begin() + hb.end, f.code.begin() + last - 1);
+        int64_t size = static_cast<int64_t>(head.size() + body.size());
+        auto emit_iteration = [&](std::vector<TACInstr>& out) {
+            for (auto& l : body_labels) l.second = f.new_label();
+            out.insert(out.end(), head.begin(), head.end());
+            for (TACInstr in : body) {
+                if (in.op == TACOp::LABEL || in.op == TACOp::GOTO || in.op == TACOp::IF_FALSE) {
+                    in.label = body_labels.at(in.label);
+                }
+                out.push_back(in);
+            }
+        };
+        // Leaving straight-line code: evaluate the header once more like the
+        // final failing test did, then continue at the exit.
+        auto emit_exit = [&](std::vector<TACInstr>& out) {
+            out.insert(out.end(), head.begin(), head.end());
+            bool exit_follows = last < f.code.size() && f.code[last].op == TACOp::LABEL && f.code[last].label == test.label;
+            if (!exit_follows) out.push_back(TACInstr::jump(test.label));
+        };
+
+        Rewrite rw{first, last, {}};
+        if (trips >= 0 && trips * size <= budget) {
+            rw.code.push_back(head_label);
+            for (int64_t k = 0; k < trips; ++k) emit_iteration(rw.code);
+            emit_exit(rw.code);
+        } else if (factor > 1 && factor * size <= budget && (trips < 0 || trips >= factor)) {
+            // The unrolled loop runs while all factor copies pass the test:
+            // i REL n - (factor - 1) * step.
+            int64_t guard = bound - (factor - 1) * step;
+            if (guard < INT32_MIN || guard > INT32_MAX) continue;
+            int32_t top = f.new_label();
+            Operand t = f.new_temp();
+            rw.code.push_back(TACInstr::label_def(top));
+            rw.code.push_back(TACInstr::binary(rel, t, iv, Operand::constant(static_cast<int32_t>(guard))));
+            rw.code.push_back(TACInstr::if_false(t, head_label.label));
+            for (int k = 0; k < factor; ++k) emit_iteration(rw.code);
+            rw.code.push_back(TACInstr::jump(top));
+            rw.code.push_back(head_label);
+            if (trips >= 0) {
+                for (int64_t k = 0; k < trips % factor; ++k) emit_iteration(rw.code);
+                emit_exit(rw.code);
+            } else {
+                rw.code.insert(rw.code.end(), f.code.begin() + first + 1, f.code.begin() + last);
+                f.unrolled.push_back(head_label.label);
             }
+            f.unrolled.push_back(top);
+        } else {
+            continue;
         }
+        rewrites.push_back(std::move(rw));
     }
-    // Add variables used in constant folding
-    used.insert(global_used_vars.begin(), global_used_vars.end());
-    // Second pass: keep only assignments whose LHS is used or are control/label lines
-    for (size_t i = 0; i < code.size(); ++i) {
-        const auto& line = code[i];
-        if (line.empty() || line.back() == ':' || line.find("goto") == 0 || line.find("ifFalse") == 0 || line.find("return") == 0) {
-            new_code.push_back(line);
+    if (rewrites.empty()) return false;
+
+    std::sort(rewrites.begin(), rewrites.end(), [](const Rewrite& a, const Rewrite& b) { return a.begin < b.begin; });
+    std::vector<TACInstr> new_code;
+    new_code.reserve(f.code.size());
+    uint32_t at = 0;
+    for (const Rewrite& rw : rewrites) {
+        new_code.insert(new_code.end(), f.code.begin() + at, f.code.begin() + rw.begin);
+        new_code.insert(new_code.end(), rw.code.begin(), rw.code.end());
+        at = rw.end;
+    }
+    new_code.insert(new_code.end(), f.code.begin() + at, f.code.end());
+    f.code.swap(new_code);
+    return true;
+}
+
+// Vectorizes innermost loops shaped like the generated for loops: a header
+// testing i < n (or i <= n) against a constant, and a body of one block that
+// ends in i's only update, i = i + 1. Every value the body computes is
+// classed as a scalar (the same on every iteration's lane, computed as
+// before), i + c (only usable as an index), a vector, or part of a sum: each
+// read of a[i + c] becomes a vector load, arithmetic on vectors becomes +, -
+// and * lane by lane with scalars splat across the lanes, a[i + c] = x a
+// vector store, and s = s + x (or s - x), the only use of a variable carried
+// around the loop, adds x into a vector accumulator. A loop running
+// vector_width iterations per test is put in front of the original, which
+// stays as the epilogue for the last few; the accumulators' lanes are added
+// into their sums in between. A loop that stores to an array may only access
+// that array at the one offset it stores to, so no iteration reads what
+// another writes, and names the body assigns must be dead after the loop.
+bool Optimizer::loop_vectorization(TACFunction& f, PassStats&) const {
+    const int32_t width = options.vector_width;
+    if (width < 2 || (f.vector_width > 1 && f.vector_width != width)) return false;
+    CFG cfg(f.code);
+    if (cfg.size() == 0) return false;
+    DominatorTree dom(cfg);
+    LoopForest forest(cfg, dom);
+    if (forest.loops.empty()) return false;
+    InductionVariables ivs(f, cfg, forest);
+    Liveness liveness(f, cfg);
+    auto live_into = [&](BlockId b, size_t n) {
+        uint32_t s = liveness.slot(n);
+        return s != Liveness::NO_SLOT && liveness.live_in[b].test(s);
+    };
+
+    struct Lane {
+        // SUM is a variable carried around the loop, READ one whose value
+        // has gone into a PARTIAL, DONE one already assigned its sum (or i
+        // once updated).
+        enum Kind : unsigned char { UNSET, SCALAR, INDEX, VECTOR, SUM, READ, PARTIAL, DONE } kind;
+        Operand op;     // SCALAR: the value; VECTOR, PARTIAL: the vector
+        int64_t offset; // INDEX: i + offset
+        size_t sum;     // PARTIAL: the variable summed into
+        TACOp sign;     // PARTIAL: VADD or VSUB
+    };
+    struct Access {
+        int32_t array;
+        int64_t offset;
+        bool store;
+    };
+    struct Insert {
+        uint32_t at;
+        std::vector<TACInstr> code;
+    };
+    std::vector<Insert> inserts;
+    for (size_t l = 0; l < forest.loops.size(); ++l) {
+        const Loop& loop = forest.loops[l];
+        if (!loop.children.empty() || loop.latches.size() != 1 || loop.blocks.size() != 2) continue;
+        BlockId h = loop.header, latch = loop.latches[0];
+        if (latch != h + 1) continue;
+        const BasicBlock& hb = cfg.blocks[h];
+        const BasicBlock& lb = cfg.blocks[latch];
+        if (hb.end - hb.begin != 3) continue;
+        const TACInstr& head_label = f.code[hb.begin];
+        const TACInstr& cond = f.code[hb.begin + 1];
+        const TACInstr& test = f.code[hb.begin + 2];
+        const TACInstr& back = f.code[lb.end - 1];
+        if (head_label.op != TACOp::LABEL || test.op != TACOp::IF_FALSE || !cond.has_dst() || cond.dst != test.a) continue;
+        if (back.op != TACOp::GOTO || back.label != head_label.label) continue;
+        if (std::find(f.vectorized.begin(), f.vectorized.end(), head_label.label) != f.vectorized.end()) continue;
+        BlockId exit = cfg.block_of_label(test.label);
+        if (exit == CFG::NO_BLOCK || forest.contains(static_cast<int>(l), exit)) continue;
+
+        // The vector loop runs while all width lanes pass the test:
+        // i REL n - (width - 1).
+        TACOp rel = cond.op;
+        Operand iv = cond.a;
+        int64_t bound;
+        if ((rel == TACOp::LT || rel == TACOp::LE) && cond.a.is_name() && cond.b.is_const()) {
+            bound = cond.b.value;
+        } else if ((rel == TACOp::GT || rel == TACOp::GE) && cond.b.is_name() && cond.a.is_const()) {
+            iv = cond.b;
+            bound = cond.a.value;
+            rel = rel == TACOp::GT ? TACOp::LT : TACOp::LE;
+        } else {
             continue;
         }
-        std::smatch m;
-        if (std::regex_match(line, m, assign_re)) {
-            std::string lhs = m[1];
-            bool is_increment = false;
-            for (int j = (int)i - 1; j >= 0; --j) {
-                if (!code[j].empty() && code[j].back() == ':') {
-                    std::string label = code[j].substr(0, code[j].size() - 1);
-                    for (size_t k = i + 1; k < code.size(); ++k) {
-                        if (code[k].find("goto " + label) == 0) {
-                            is_increment = true;
-                            break;
-                        }
-                        if (!code[k].empty() && code[k].back() == ':') break;
-                    }
-                    break;
+        int64_t guard = bound - (width - 1);
+        if (guard < INT32_MIN || (rel == TACOp::LE && bound == INT32_MAX)) continue;
+        const BasicIV* basic = ivs.find(static_cast<int>(l), iv);
+        if (!basic || basic->updates.size() != 1 || basic->steps[0] != 1) continue;
+        uint32_t update = basic->updates[0];
+        if (update < lb.begin || update >= lb.end) continue;
+
+        std::set<size_t> written;
+        for (uint32_t i = hb.begin; i < lb.end; ++i) {
+            if (f.code[i].has_dst()) written.insert(liveness.index(f.code[i].dst));
+        }
+        std::map<size_t, Lane> lanes; // names the loop assigns; any other name is a scalar
+        for (size_t n : written) {
+            Lane::Kind kind = n == liveness.index(iv) ? Lane::INDEX : live_into(h, n) ? Lane::SUM : Lane::UNSET;
+            lanes[n] = Lane{kind, Operand::none(), 0, 0, TACOp::COPY};
+        }
+
+        int32_t temps = f.temp_count, labels = f.label_count;
+        bool ok = true;
+        std::vector<TACInstr> pre, body;
+        std::map<Operand, Operand> splats;  // invariant scalar -> vector made before the loop
+        std::map<int64_t, Operand> indexes; // offset -> i + offset
+        std::map<size_t, Operand> sums;     // summed variable -> accumulator
+        std::vector<Access> accesses;
+        std::set<int32_t> scalar_loads;
+        auto lane = [&](const Operand& o) {
+            if (o.is_name()) {
+                auto it = lanes.find(liveness.index(o));
+                if (it != lanes.end()) return it->second;
+            }
+            return Lane{Lane::SCALAR, o, 0, 0, TACOp::COPY};
+        };
+        auto index_at = [&](int64_t offset) {
+            if (offset == 0) return iv;
+            auto it = indexes.find(offset);
+            if (it != indexes.end()) return it->second;
+            Operand t = f.new_temp();
+            body.push_back(TACInstr::binary(TACOp::ADD, t, iv, Operand::constant(static_cast<int32_t>(offset))));
+            return indexes[offset] = t;
+        };
+        auto vector_of = [&](const Lane& x) {
+            if (x.kind == Lane::VECTOR) return x.op;
+            if (x.kind != Lane::SCALAR) {
+                ok = false;
+                return Operand::none();
+            }
+            bool invariant = !x.op.is_name() || !written.count(liveness.index(x.op));
+            if (invariant && splats.count(x.op)) return splats[x.op];
+            Operand v = f.new_temp();
+            (invariant ? pre : body).push_back(TACInstr::unary(TACOp::VSPLAT, v, x.op));
+            if (invariant) splats[x.op] = v;
+            return v;
+        };
+        auto assign = [&](const Operand& dst, const Lane& x) {
+            size_t d = liveness.index(dst);
+            Lane& cur = lanes[d];
+            if (cur.kind == Lane::SUM || cur.kind == Lane::READ) {
+                if (cur.kind != Lane::READ || x.kind != Lane::PARTIAL || x.sum != d) {
+                    ok = false;
+                    return;
                 }
+                Operand& acc = sums[d];
+                acc = f.new_temp();
+                pre.push_back(TACInstr::unary(TACOp::VSPLAT, acc, Operand::constant(0)));
+                body.push_back(TACInstr::binary(x.sign, acc, acc, x.op));
+                cur.kind = Lane::DONE;
+            } else if (cur.kind == Lane::DONE || d == liveness.index(iv)) {
+                ok = false;
+            } else {
+                cur = x;
             }
-            if (used.count(lhs) || is_increment) {
-                new_code.push_back(line);
+        };
+        for (uint32_t i = lb.begin; i + 1 < lb.end && ok; ++i) {
+            const TACInstr& in = f.code[i];
+            if (i == update) {
+                lanes[liveness.index(iv)].kind = Lane::DONE;
+                continue;
             }
-        } else {
-            new_code.push_back(line);
+            Lane a = lane(in.a), b = lane(in.b);
+            Lane scalar{Lane::SCALAR, in.dst, 0, 0, TACOp::COPY};
+            if (in.op == TACOp::COPY) {
+                if (a.kind == Lane::SCALAR) body.push_back(in);
+                if (a.kind == Lane::SCALAR || a.kind == Lane::INDEX || a.kind == Lane::VECTOR || a.kind == Lane::PARTIAL) {
+                    assign(in.dst, a.kind == Lane::SCALAR ? scalar : a);
+                } else {
+                    ok = false;
+                }
+            } else if (in.op == TACOp::LOAD && a.kind == Lane::INDEX) {
+                Operand v = f.new_temp();
+                body.push_back(TACInstr::load(TACOp::VLOAD, v, in.label, index_at(a.offset)));
+                accesses.push_back(Access{in.label, a.offset, false});
+                assign(in.dst, Lane{Lane::VECTOR, v, 0, 0, TACOp::COPY});
+            } else if (in.op == TACOp::LOAD && a.kind == Lane::SCALAR) {
+                body.push_back(in);
+                scalar_loads.insert(in.label);
+                assign(in.dst, scalar);
+            } else if (in.op == TACOp::STORE && a.kind == Lane::INDEX) {
+                Operand v = vector_of(b);
+                body.push_back(TACInstr::store(TACOp::VSTORE, in.label, index_at(a.offset), v));
+                accesses.push_back(Access{in.label, a.offset, true});
+            } else if ((in.op == TACOp::ADD || in.op == TACOp::SUB) && (a.kind == Lane::SUM || b.kind == Lane::SUM)) {
+                bool left = a.kind == Lane::SUM;
+                if ((!left && in.op == TACOp::SUB) || (left && b.kind == Lane::SUM)) {
+                    ok = false;
+                    continue;
+                }
+                size_t s = liveness.index(left ? in.a : in.b);
+                Operand x = vector_of(left ? b : a);
+                lanes[s].kind = Lane::READ;
+                assign(in.dst, Lane{Lane::PARTIAL, x, 0, s, in.op == TACOp::SUB ? TACOp::VSUB : TACOp::VADD});
+            } else if ((in.op == TACOp::ADD || in.op == TACOp::SUB) && (a.kind == Lane::PARTIAL || b.kind == Lane::PARTIAL)) {
+                // (s + x) + y is s + (x + y), (s - x) + y is s - (x - y), and so on.
+                bool left = a.kind == Lane::PARTIAL;
+                const Lane& p = left ? a : b;
+                if (!left && in.op == TACOp::SUB) {
+                    ok = false;
+                    continue;
+                }
+                Operand y = vector_of(left ? b : a);
+                Operand v = f.new_temp();
+                body.push_back(TACInstr::binary((p.sign == TACOp::VADD) == (in.op == TACOp::ADD) ? TACOp::VADD : TACOp::VSUB, v, p.op, y));
+                assign(in.dst, Lane{Lane::PARTIAL, v, 0, p.sum, p.sign});
+            } else if (is_binary(in.op) && a.kind == Lane::SCALAR && b.kind == Lane::SCALAR) {
+                body.push_back(in);
+                assign(in.dst, scalar);
+            } else if ((in.op == TACOp::ADD || in.op == TACOp::SUB) && a.kind == Lane::INDEX && b.op.is_const()) {
+                int64_t offset = a.offset + (in.op == TACOp::ADD ? b.op.value : -static_cast<int64_t>(b.op.value));
+                assign(in.dst, Lane{Lane::INDEX, Operand::none(), offset, 0, TACOp::COPY});
+            } else if (in.op == TACOp::ADD && b.kind == Lane::INDEX && a.op.is_const()) {
+                assign(in.dst, Lane{Lane::INDEX, Operand::none(), b.offset + a.op.value, 0, TACOp::COPY});
+            } else if (in.op == TACOp::ADD || in.op == TACOp::SUB || in.op == TACOp::MUL) {
+                Operand x = vector_of(a), y = vector_of(b);
+                Operand v = f.new_temp();
+                TACOp op = in.op == TACOp::ADD ? TACOp::VADD : in.op == TACOp::SUB ? TACOp::VSUB : TACOp::VMUL;
+                body.push_back(TACInstr::binary(op, v, x, y));
+                assign(in.dst, Lane{Lane::VECTOR, v, 0, 0, TACOp::COPY});
+            } else {
+                ok = false;
+            }
+        }
+        for (const auto& entry : lanes) {
+            if (entry.second.kind == Lane::SUM || entry.second.kind == Lane::READ) ok = false;
+            if (entry.second.kind == Lane::INDEX && (entry.second.offset < INT32_MIN || entry.second.offset > INT32_MAX)) ok = false;
+        }
+        for (size_t n : written) {
+            if (n != liveness.index(iv) && !sums.count(n) && live_into(exit, n)) ok = false;
+        }
+        bool vector_access = false;
+        for (const Access& x : accesses) {
+            vector_access = true;
+            for (const Access& y : accesses) {
+                if (x.store && y.array == x.array && y.offset != x.offset) ok = false;
+            }
+            if (x.store && scalar_loads.count(x.array)) ok = false;
+        }
+        if (!ok || !vector_access) {
+            f.temp_count = temps;
+            f.label_count = labels;
+            continue;
         }
+
+        int32_t top = f.new_label(), past = f.new_label();
+        Operand t = f.new_temp();
+        Insert vector_loop{hb.begin, std::move(pre)};
+        std::vector<TACInstr>& out = vector_loop.code;
+        out.push_back(TACInstr::label_def(top));
+        out.push_back(TACInstr::binary(rel, t, iv, Operand::constant(static_cast<int32_t>(guard))));
+        out.push_back(TACInstr::if_false(t, past));
+        out.insert(out.end(), body.begin(), body.end());
+        out.push_back(TACInstr::binary(TACOp::ADD, iv, iv, Operand::constant(width)));
+        out.push_back(TACInstr::jump(top));
+        out.push_back(TACInstr::label_def(past));
+        for (const auto& sum : sums) {
+            Operand s = f.new_temp();
+            Operand var = sum.first < f.vars.size() ? Operand::var(static_cast<int32_t>(sum.first))
+                                                    : Operand::temp(static_cast<int32_t>(sum.first - f.vars.size()));
+            out.push_back(TACInstr::unary(TACOp::VSUM, s, sum.second));
+            out.push_back(TACInstr::binary(TACOp::ADD, var, var, s));
+        }
+        inserts.push_back(std::move(vector_loop));
+        f.vectorized.push_back(head_label.label);
+    }
+    if (inserts.empty()) return false;
+
+    f.vector_width = width;
+    std::sort(inserts.begin(), inserts.end(), [](const Insert& a, const Insert& b) { return a.at < b.at; });
+    std::vector<TACInstr> new_code;
+    new_code.reserve(f.code.size() + 32 * inserts.size());
+    uint32_t at = 0;
+    for (const Insert& ins : inserts) {
+        new_code.insert(new_code.end(), f.code.begin() + at, f.code.begin() + ins.at);
+        new_code.insert(new_code.end(), ins.code.begin(), ins.code.end());
+        at = ins.at;
+    }
+    new_code.insert(new_code.end(), f.code.begin() + at, f.code.end());
+    f.code.swap(new_code);
+    return true;
+}
+
+// x = x and the second copy of x = y; y = x change nothing. t = a op b (or a
+// copy or load); v = t, where the temporary t is assigned again further down
+// the block and v keeps its value as long as t is read, computes a op b
+// straight into v, and the reads of t in between read v instead.
+bool Optimizer::remove_redundant_copies(TACFunction&, std::vector<TACInstr>& code) const {
+    std::vector<char> removed(code.size(), 0);
+    bool changed = false;
+    for (size_t i = 0; i < code.size(); ++i) {
+        if (code[i].op == TACOp::COPY && code[i].a == code[i].dst) {
+            removed[i] = 1;
+            changed = true;
+        }
+    }
+    std::vector<size_t> next_write(code.size(), SIZE_MAX); // where an assignment's target is assigned next
+    std::unordered_map<Operand, size_t, OperandHash> later;
+    for (size_t i = code.size(); i-- > 0;) {
+        if (!code[i].has_dst() || removed[i]) continue;
+        auto it = later.find(code[i].dst);
+        if (it != later.end()) next_write[i] = it->second;
+        later[code[i].dst] = i;
+    }
+    for (size_t i = 0; i + 1 < code.size(); ++i) {
+        TACInstr& cur = code[i];
+        const TACInstr& next = code[i+1];
+        if (removed[i] || removed[i+1] || !cur.has_dst() || next.op != TACOp::COPY || next.a != cur.dst) continue;
+        if (cur.op == TACOp::COPY && next.dst == cur.a) {
+            removed[i+1] = 1;
+            changed = true;
+            continue;
+        }
+        if (cur.dst.kind != Operand::TEMP || next.dst == cur.dst || next_write[i] == SIZE_MAX) continue;
+        if (cur.op != TACOp::COPY && !is_binary(cur.op) && cur.op != TACOp::LOAD) continue;
+        Operand t = cur.dst, v = next.dst;
+        bool v_changed = false, ok = true;
+        for (size_t j = i + 2; j <= next_write[i] && ok; ++j) {
+            if (v_changed && (code[j].a == t || code[j].b == t)) ok = false;
+            if (code[j].dst == v) v_changed = true;
+        }
+        if (!ok) continue;
+        for (size_t j = i + 2; j <= next_write[i]; ++j) {
+            if (code[j].a == t) code[j].a = v;
+            if (code[j].b == t) code[j].b = v;
+        }
+        cur.dst = v;
+        removed[i+1] = 1;
+        changed = true;
+    }
+    if (!changed) return false;
+    std::vector<TACInstr> new_code;
+    new_code.reserve(code.size());
+    for (size_t i = 0; i < code.size(); ++i) {
+        if (!removed[i]) new_code.push_back(code[i]);
     }
-    return new_code;
-} 
\ No newline at end of file
+    code.swap(new_code);
+    return true;
+}
+
+// Removes assignments to names that are not strongly live, i.e. never reach
+// a return, a branch or (at top level) the program's exit.
+bool Optimizer::full_dead_code_elimination(TACFunction& f, PassStats& stats) const {
+    CFG cfg(f.code);
+    Liveness liveness(f, cfg, true);
+    std::vector<char> keep(f.code.size(), 1);
+    bool changed = false;
+    for (BlockId b = 0; b < cfg.size(); ++b) {
+        liveness.walk(b, [&](uint32_t i, bool dst_live) {
+            if (!dst_live) {
+                keep[i] = 0;
+                stats.eliminated++;
+                changed = true;
+            }
+        });
+    }
+    if (!changed) return false;
+    std::vector<TACInstr> new_code;
+    new_code.reserve(f.code.size());
+    for (size_t i = 0; i < f.code.size(); ++i) {
+        if (keep[i]) new_code.push_back(f.code[i]);
+    }
+    f.code.swap(new_code);
+    return true;
+}
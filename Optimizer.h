@@ -1,27 +1,70 @@
 #ifndef OPTIMIZER_H
 #define OPTIMIZER_H
-#include <vector>
 #include <string>
+#include <unordered_set>
+#include <vector>
+#include "TAC.h"
+
+struct OptimizerOptions {
+    std::vector<std::string> passes; // in the order they are tried; empty means the default pipeline
+    int unroll_factor = 4;           // body copies per iteration of a partially unrolled loop
+    int unroll_budget = 128;         // most instructions an unrolled loop may grow to
+    int vector_width = 4;            // lanes of vectorized loops; 1 turns vectorization off
+    int jobs = 1;                    // worker threads optimizing functions concurrently
+};
 
 class Optimizer {
 public:
-    Optimizer(const std::vector<std::string>& tac);
-    std::vector<std::string> optimize();
+    struct PassStats {
+        std::string name;
+        int runs = 0;
+        int changes = 0;
+        int blocks_skipped = 0; // block-local passes: blocks known to be unchanged
+        int eliminated = 0;     // instructions the pass removed or made redundant
+        double ms = 0;
+    };
+
+    // Throws on unknown pass names.
+    explicit Optimizer(const TACProgram& tac, const OptimizerOptions& options = OptimizerOptions());
+    TACProgram optimize();
+    const std::vector<PassStats>& stats() const { return pass_stats; }
+
+    static std::vector<std::string> pass_names();
+    static std::vector<std::string> default_pipeline();
+
 private:
-    std::vector<std::string> tac;
-    bool is_control_or_label(const std::string& line) const;
-    std::vector<std::string> constant_folding(const std::vector<std::string>& code) const;
-    std::vector<std::string> algebraic_simplification(const std::vector<std::string>& code) const;
-    std::vector<std::string> common_subexpression_elimination(const std::vector<std::string>& code) const;
-    std::vector<std::string> advanced_loop_invariant_code_motion(const std::vector<std::string>& code) const;
-    std::vector<std::string> remove_useless_assignments(const std::vector<std::string>& code) const;
-    std::vector<std::string> strength_reduction(const std::vector<std::string>& code) const;
-    std::vector<std::string> induction_variable_elimination(const std::vector<std::string>& code) const;
-    std::vector<std::string> full_dead_code_elimination(const std::vector<std::string>& code) const;
-    std::vector<std::string> remove_redundant_copies(const std::vector<std::string>& code) const;
-    std::vector<std::string> constant_propagation_and_folding(const std::vector<std::string>& code) const;
-    std::vector<std::string> induction_variable_simplification(const std::vector<std::string>& code) const;
-    std::vector<std::string> loop_unrolling(const std::vector<std::string>& code) const;
+    // A pass either rewrites the whole function or, when it only looks inside
+    // one basic block, rewrites one block's instructions at a time.
+    typedef bool (Optimizer::*PassFn)(TACFunction&, PassStats&) const;
+    typedef bool (Optimizer::*BlockPassFn)(TACFunction&, std::vector<TACInstr>&) const;
+    struct PassInfo {
+        const char* name;
+        PassFn run;
+        BlockPassFn run_block;
+    };
+    static const PassInfo passes[];
+    static const int max_sweeps = 10; // Prevent infinite loops
+
+    TACProgram tac;
+    OptimizerOptions options;
+    std::vector<int> pipeline;        // indices into passes
+    std::vector<PassStats> pass_stats; // parallel to pipeline, summed over all functions
+
+    // Passes only touch the function they are given and the stats passed in,
+    // so functions can be optimized on different threads.
+    void optimize_function(TACFunction& f, std::vector<PassStats>& stats) const;
+    bool run_per_block(BlockPassFn pass, TACFunction& f, std::unordered_set<uint64_t>& clean, PassStats& stats) const;
+    bool sparse_conditional_constant_propagation(TACFunction& f, PassStats& stats) const;
+    bool algebraic_simplification(TACFunction& f, std::vector<TACInstr>& code) const;
+    bool global_value_numbering(TACFunction& f, PassStats& stats) const;
+    bool loop_invariant_code_motion(TACFunction& f, PassStats& stats) const;
+    bool induction_variable_strength_reduction(TACFunction& f, PassStats& stats) const;
+    bool remove_useless_assignments(TACFunction& f, std::vector<TACInstr>& code) const;
+    bool strength_reduction(TACFunction& f, std::vector<TACInstr>& code) const;
+    bool full_dead_code_elimination(TACFunction& f, PassStats& stats) const;
+    bool remove_redundant_copies(TACFunction& f, std::vector<TACInstr>& code) const;
+    bool loop_unrolling(TACFunction& f, PassStats& stats) const;
+    bool loop_vectorization(TACFunction& f, PassStats& stats) const;
 };
 
-#endif // OPTIMIZER_H 
\ No newline at end of file
+#endif // OPTIMIZER_H
@@ -0,0 +1,49 @@
+#include "OutputWriter.h"
+#include "utils.h"
+using namespace std;
+
+OutputWriter::OutputWriter(bool background) {
+    if (background) worker = thread(&OutputWriter::run, this);
+}
+
+OutputWriter::~OutputWriter() {
+    finish();
+}
+
+void OutputWriter::write(string path, string contents) {
+    if (!worker.joinable()) {
+        if (!write_to_file(path, contents, false)) failed.push_back(path);
+        return;
+    }
+    {
+        lock_guard<mutex> lock(m);
+        queue.emplace_back(move(path), move(contents));
+    }
+    ready.notify_one();
+}
+
+vector<string> OutputWriter::finish() {
+    if (worker.joinable()) {
+        {
+            lock_guard<mutex> lock(m);
+            closing = true;
+        }
+        ready.notify_one();
+        worker.join();
+    }
+    return failed;
+}
+
+void OutputWriter::run() {
+    unique_lock<mutex> lock(m);
+    for (;;) {
+        ready.wait(lock, [this] { return closing || !queue.empty(); });
+        if (queue.empty()) return;
+        pair<string, string> file = move(queue.front());
+        queue.pop_front();
+        lock.unlock();
+        bool ok = write_to_file(file.first, file.second, false);
+        lock.lock();
+        if (!ok) failed.push_back(file.first);
+    }
+}
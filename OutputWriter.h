@@ -0,0 +1,35 @@
+#ifndef OUTPUTWRITER_H
+#define OUTPUTWRITER_H
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Writes output files, either on the spot or, in background mode, on a
+// thread of its own so the compiler can run the next stage meanwhile.
+class OutputWriter {
+public:
+    explicit OutputWriter(bool background);
+    ~OutputWriter();
+    OutputWriter(const OutputWriter&) = delete;
+    OutputWriter& operator=(const OutputWriter&) = delete;
+
+    void write(std::string path, std::string contents);
+    // Waits for every queued write; returns the paths that could not be written.
+    std::vector<std::string> finish();
+
+private:
+    std::thread worker;
+    std::mutex m;
+    std::condition_variable ready;    // a write was queued, or finish() was called
+    std::deque<std::pair<std::string, std::string>> queue;
+    std::vector<std::string> failed;
+    bool closing = false;
+
+    void run();
+};
+
+#endif // OUTPUTWRITER_H
@@ -1,235 +1,260 @@
 #include "Parser.h"
 #include <stdexcept>
 
-Parser::Parser(const std::vector<Token>& tokens_)
-    : tokens(tokens_), pos(0), current_token(tokens.empty() ? Token("", "", 0) : tokens[0]) {}
+const Token Parser::eof_token(TokenKind::EOI, "", 0);
+
+Parser::Parser(const std::vector<Token>& tokens, AST& ast_)
+    : begin(tokens.data()), current(tokens.empty() ? &eof_token : tokens.data()),
+      end(tokens.data() + tokens.size()), ast(ast_) {
+    ast.reserve(tokens.size());
+}
 
 void Parser::advance() {
-    pos++;
-    if (pos < tokens.size())
-        current_token = tokens[pos];
-    else
-        current_token = Token("", "", 0);
+    if (current != &eof_token && ++current == end)
+        current = &eof_token;
 }
 
-void Parser::eat(const std::string& token_type) {
-    if (!current_token.type.empty() && current_token.type == token_type) {
+void Parser::eat(TokenKind kind) {
+    if (current->kind == kind) {
         advance();
     } else {
-        throw std::runtime_error("Expected " + token_type + ", got " + current_token.type);
+        throw std::runtime_error(std::string("Expected ") + token_kind_name(kind) + ", got " + token_kind_name(current->kind));
     }
 }
 
-std::shared_ptr<ASTNode> Parser::parse() {
-    if (!current_token.type.empty() && current_token.type == "INT") {
-        return function_def();
+// A file is either a statement list or a sequence of function definitions;
+// several functions share a PROGRAM root, a single one is the root itself.
+NodeId Parser::parse() {
+    if (at(TokenKind::INT)) {
+        size_t mark = stack.size();
+        while (at(TokenKind::INT)) stack.push_back(function_def());
+        if (stack.size() - mark == 1) {
+            ast.root = stack.back();
+            stack.pop_back();
+        } else {
+            ast.root = ast.add(NodeKind::PROGRAM, AST::NO_VALUE, stack, mark);
+        }
     } else {
-        return program();
+        ast.root = program();
     }
+    return ast.root;
 }
 
-std::shared_ptr<ASTNode> Parser::function_def() {
-    eat("INT");
-    std::string func_name = current_token.value;
-    eat("ID");
-    eat("LPAREN");
-    eat("RPAREN");
-    eat("LBRACE");
-    std::vector<std::shared_ptr<ASTNode>> body;
-    while (!current_token.type.empty() && current_token.type != "RBRACE") {
-        if (current_token.type == "ID" || current_token.type == "WHILE" || current_token.type == "IF" || current_token.type == "FOR" || current_token.type == "INT" || current_token.type == "RETURN") {
-            body.push_back(statement());
+// Pushes the statements up to (not including) the closing brace onto the
+// stack; stray tokens are skipped.
+void Parser::block() {
+    while (!at(TokenKind::EOI) && !at(TokenKind::RBRACE)) {
+        if (starts_statement(current->kind)) {
+            NodeId stmt = statement();
+            stack.push_back(stmt);
         } else {
             advance();
         }
     }
-    eat("RBRACE");
-    return std::make_shared<ASTNode>("FUNCTION", func_name, body);
 }
 
-std::shared_ptr<ASTNode> Parser::program() {
-    std::vector<std::shared_ptr<ASTNode>> stmts;
-    while (!current_token.type.empty()) {
-        if (current_token.type == "ID" || current_token.type == "WHILE" || current_token.type == "IF" || current_token.type == "FOR" || current_token.type == "INT" || current_token.type == "RETURN") {
-            stmts.push_back(statement());
+NodeId Parser::function_def() {
+    size_t first = position();
+    eat(TokenKind::INT);
+    uint32_t func_name = intern_name();
+    eat(TokenKind::ID);
+    eat(TokenKind::LPAREN);
+    eat(TokenKind::RPAREN);
+    eat(TokenKind::LBRACE);
+    size_t mark = stack.size();
+    block();
+    eat(TokenKind::RBRACE);
+    spans.push_back(Span{first, position()});
+    return ast.add(NodeKind::FUNCTION, func_name, stack, mark);
+}
+
+NodeId Parser::program() {
+    size_t mark = stack.size();
+    while (!at(TokenKind::EOI)) {
+        if (starts_statement(current->kind)) {
+            NodeId stmt = statement();
+            stack.push_back(stmt);
         } else {
             advance();
         }
     }
-    return std::make_shared<ASTNode>("PROGRAM", "", stmts);
+    return ast.add(NodeKind::PROGRAM, AST::NO_VALUE, stack, mark);
 }
 
-std::shared_ptr<ASTNode> Parser::statement() {
-    if (current_token.type == "INT") {
-        return declaration();
-    } else if (current_token.type == "ID") {
-        auto node = assignment();
-        eat("END");
-        return node;
-    } else if (current_token.type == "WHILE") {
-        return while_stmt();
-    } else if (current_token.type == "FOR") {
-        return for_stmt();
-    } else if (current_token.type == "IF") {
-        return if_stmt();
-    } else if (current_token.type == "RETURN") {
-        return return_stmt();
-    } else {
-        throw std::runtime_error("Invalid statement at " + current_token.type);
+NodeId Parser::statement() {
+    switch (current->kind) {
+        case TokenKind::INT:
+            return declaration();
+        case TokenKind::ID: {
+            NodeId node = assignment();
+            eat(TokenKind::END);
+            return node;
+        }
+        case TokenKind::WHILE:
+            return while_stmt();
+        case TokenKind::FOR:
+            return for_stmt();
+        case TokenKind::IF:
+            return if_stmt();
+        case TokenKind::RETURN:
+            return return_stmt();
+        default:
+            throw std::runtime_error(std::string("Invalid statement at ") + token_kind_name(current->kind));
     }
 }
 
-std::shared_ptr<ASTNode> Parser::declaration() {
-    eat("INT");
-    std::string var = current_token.value;
-    eat("ID");
-    if (!current_token.type.empty() && current_token.type == "ASSIGN") {
-        eat("ASSIGN");
-        auto expr_node = expr();
-        eat("END");
-        return std::make_shared<ASTNode>("DECL", var, std::vector<std::shared_ptr<ASTNode>>{expr_node});
+NodeId Parser::declaration() {
+    eat(TokenKind::INT);
+    uint32_t var = intern_name();
+    eat(TokenKind::ID);
+    if (at(TokenKind::LBRACKET)) {
+        eat(TokenKind::LBRACKET);
+        uint32_t length = intern_literal();
+        eat(TokenKind::NUMBER);
+        NodeId length_node = ast.add(NodeKind::NUMBER, length);
+        eat(TokenKind::RBRACKET);
+        eat(TokenKind::END);
+        return ast.add(NodeKind::ARRAY_DECL, var, {length_node});
+    } else if (at(TokenKind::ASSIGN)) {
+        eat(TokenKind::ASSIGN);
+        NodeId expr_node = expr();
+        eat(TokenKind::END);
+        return ast.add(NodeKind::DECL, var, {expr_node});
     } else {
-        eat("END");
-        return std::make_shared<ASTNode>("DECL", var);
+        eat(TokenKind::END);
+        return ast.add(NodeKind::DECL, var);
     }
 }
 
-std::shared_ptr<ASTNode> Parser::for_stmt() {
-    eat("FOR");
-    eat("LPAREN");
-    auto init = statement();
-    auto cond = condition();
-    eat("END");
-    auto update = assignment();
-    eat("RPAREN");
-    eat("LBRACE");
-    std::vector<std::shared_ptr<ASTNode>> body;
-    while (!current_token.type.empty() && current_token.type != "RBRACE") {
-        if (current_token.type == "ID" || current_token.type == "WHILE" || current_token.type == "IF" || current_token.type == "FOR" || current_token.type == "INT" || current_token.type == "RETURN") {
-            body.push_back(statement());
-        } else {
-            advance();
-        }
-    }
-    eat("RBRACE");
-    body.push_back(update);
-    return std::make_shared<ASTNode>("FOR", "", std::vector<std::shared_ptr<ASTNode>>{init, std::make_shared<ASTNode>("WHILE", "", std::vector<std::shared_ptr<ASTNode>>{cond, std::make_shared<ASTNode>("BODY", "", body)})});
-}
-
-std::shared_ptr<ASTNode> Parser::return_stmt() {
-    eat("RETURN");
-    auto expr_node = expr();
-    eat("END");
-    return std::make_shared<ASTNode>("RETURN", "", std::vector<std::shared_ptr<ASTNode>>{expr_node});
-}
-
-std::shared_ptr<ASTNode> Parser::while_stmt() {
-    eat("WHILE");
-    eat("LPAREN");
-    auto cond = condition();
-    eat("RPAREN");
-    eat("LBRACE");
-    std::vector<std::shared_ptr<ASTNode>> body;
-    while (!current_token.type.empty() && current_token.type != "RBRACE") {
-        if (current_token.type == "ID" || current_token.type == "WHILE" || current_token.type == "IF" || current_token.type == "FOR" || current_token.type == "INT" || current_token.type == "RETURN") {
-            body.push_back(statement());
-        } else {
-            advance();
-        }
-    }
-    eat("RBRACE");
-    return std::make_shared<ASTNode>("WHILE", "", std::vector<std::shared_ptr<ASTNode>>{cond, std::make_shared<ASTNode>("BODY", "", body)});
-}
-
-std::shared_ptr<ASTNode> Parser::if_stmt() {
-    eat("IF");
-    eat("LPAREN");
-    auto cond = condition();
-    eat("RPAREN");
-    eat("LBRACE");
-    std::vector<std::shared_ptr<ASTNode>> then_body;
-    while (!current_token.type.empty() && current_token.type != "RBRACE") {
-        if (current_token.type == "ID" || current_token.type == "WHILE" || current_token.type == "IF" || current_token.type == "FOR" || current_token.type == "INT" || current_token.type == "RETURN") {
-            then_body.push_back(statement());
-        } else {
-            advance();
-        }
-    }
-    eat("RBRACE");
-    std::vector<std::shared_ptr<ASTNode>> else_body;
-    if (!current_token.type.empty() && current_token.type == "ELSE") {
-        eat("ELSE");
-        eat("LBRACE");
-        while (!current_token.type.empty() && current_token.type != "RBRACE") {
-            if (current_token.type == "ID" || current_token.type == "WHILE" || current_token.type == "IF" || current_token.type == "FOR" || current_token.type == "INT" || current_token.type == "RETURN") {
-                else_body.push_back(statement());
-            } else {
-                advance();
-            }
-        }
-        eat("RBRACE");
+NodeId Parser::for_stmt() {
+    eat(TokenKind::FOR);
+    eat(TokenKind::LPAREN);
+    NodeId init = statement();
+    NodeId cond = condition();
+    eat(TokenKind::END);
+    NodeId update = assignment();
+    eat(TokenKind::RPAREN);
+    eat(TokenKind::LBRACE);
+    size_t mark = stack.size();
+    block();
+    eat(TokenKind::RBRACE);
+    stack.push_back(update);
+    NodeId body = ast.add(NodeKind::BODY, AST::NO_VALUE, stack, mark);
+    NodeId loop = ast.add(NodeKind::WHILE, AST::NO_VALUE, {cond, body});
+    return ast.add(NodeKind::FOR, AST::NO_VALUE, {init, loop});
+}
+
+NodeId Parser::return_stmt() {
+    eat(TokenKind::RETURN);
+    NodeId expr_node = expr();
+    eat(TokenKind::END);
+    return ast.add(NodeKind::RETURN, AST::NO_VALUE, {expr_node});
+}
+
+NodeId Parser::while_stmt() {
+    eat(TokenKind::WHILE);
+    eat(TokenKind::LPAREN);
+    NodeId cond = condition();
+    eat(TokenKind::RPAREN);
+    eat(TokenKind::LBRACE);
+    size_t mark = stack.size();
+    block();
+    eat(TokenKind::RBRACE);
+    NodeId body = ast.add(NodeKind::BODY, AST::NO_VALUE, stack, mark);
+    return ast.add(NodeKind::WHILE, AST::NO_VALUE, {cond, body});
+}
+
+NodeId Parser::if_stmt() {
+    eat(TokenKind::IF);
+    eat(TokenKind::LPAREN);
+    NodeId cond = condition();
+    eat(TokenKind::RPAREN);
+    eat(TokenKind::LBRACE);
+    size_t mark = stack.size();
+    block();
+    eat(TokenKind::RBRACE);
+    NodeId then_body = ast.add(NodeKind::THEN, AST::NO_VALUE, stack, mark);
+    if (at(TokenKind::ELSE)) {
+        eat(TokenKind::ELSE);
+        eat(TokenKind::LBRACE);
+        block();
+        eat(TokenKind::RBRACE);
     }
-    return std::make_shared<ASTNode>("IF", "", std::vector<std::shared_ptr<ASTNode>>{
-        cond,
-        std::make_shared<ASTNode>("THEN", "", then_body),
-        std::make_shared<ASTNode>("ELSE", "", else_body)
-    });
-}
-
-std::shared_ptr<ASTNode> Parser::condition() {
-    auto left = expr();
-    if (!current_token.type.empty() && (current_token.type == "LT" || current_token.type == "GT" || current_token.type == "LE" || current_token.type == "GE" || current_token.type == "EQ" || current_token.type == "NE")) {
-        std::string op = current_token.type;
-        eat(op);
-        auto right = expr();
-        return std::make_shared<ASTNode>("RELOP", op, std::vector<std::shared_ptr<ASTNode>>{left, right});
+    NodeId else_body = ast.add(NodeKind::ELSE, AST::NO_VALUE, stack, mark);
+    return ast.add(NodeKind::IF, AST::NO_VALUE, {cond, then_body, else_body});
+}
+
+NodeId Parser::condition() {
+    NodeId left = expr();
+    if (is_relop(current->kind)) {
+        uint32_t op = ast.literals.intern(token_kind_name(current->kind));
+        advance();
+        NodeId right = expr();
+        return ast.add(NodeKind::RELOP, op, {left, right});
     } else {
         return left;
     }
 }
 
-std::shared_ptr<ASTNode> Parser::expr() {
-    auto node = term();
-    while (!current_token.type.empty() && current_token.type == "OP" && (current_token.value == "+" || current_token.value == "-")) {
-        std::string op = current_token.value;
-        eat("OP");
-        node = std::make_shared<ASTNode>("BINOP", op, std::vector<std::shared_ptr<ASTNode>>{node, term()});
+NodeId Parser::expr() {
+    NodeId node = term();
+    while (at(TokenKind::OP) && (current->value[0] == '+' || current->value[0] == '-')) {
+        uint32_t op = intern_literal();
+        advance();
+        NodeId right = term();
+        node = ast.add(NodeKind::BINOP, op, {node, right});
     }
     return node;
 }
 
-std::shared_ptr<ASTNode> Parser::term() {
-    auto node = factor();
-    while (!current_token.type.empty() && current_token.type == "OP" && (current_token.value == "*" || current_token.value == "/")) {
-        std::string op = current_token.value;
-        eat("OP");
-        node = std::make_shared<ASTNode>("BINOP", op, std::vector<std::shared_ptr<ASTNode>>{node, factor()});
+NodeId Parser::term() {
+    NodeId node = factor();
+    while (at(TokenKind::OP) && (current->value[0] == '*' || current->value[0] == '/')) {
+        uint32_t op = intern_literal();
+        advance();
+        NodeId right = factor();
+        node = ast.add(NodeKind::BINOP, op, {node, right});
     }
     return node;
 }
 
-std::shared_ptr<ASTNode> Parser::factor() {
-    Token token = current_token;
-    if (token.type == "NUMBER") {
-        eat("NUMBER");
-        return std::make_shared<ASTNode>("NUMBER", token.value);
-    } else if (token.type == "ID") {
-        eat("ID");
-        return std::make_shared<ASTNode>("ID", token.value);
-    } else if (token.type == "LPAREN") {
-        eat("LPAREN");
-        auto node = expr();
-        eat("RPAREN");
+NodeId Parser::factor() {
+    if (at(TokenKind::NUMBER)) {
+        uint32_t literal = intern_literal();
+        advance();
+        return ast.add(NodeKind::NUMBER, literal);
+    } else if (at(TokenKind::ID)) {
+        uint32_t name = intern_name();
+        advance();
+        if (at(TokenKind::LBRACKET)) {
+            eat(TokenKind::LBRACKET);
+            NodeId index = expr();
+            eat(TokenKind::RBRACKET);
+            return ast.add(NodeKind::INDEX, name, {index});
+        }
+        return ast.add(NodeKind::ID, name);
+    } else if (at(TokenKind::LPAREN)) {
+        eat(TokenKind::LPAREN);
+        NodeId node = expr();
+        eat(TokenKind::RPAREN);
         return node;
     } else {
-        throw std::runtime_error("Invalid factor at " + token.type);
+        throw std::runtime_error(std::string("Invalid factor at ") + token_kind_name(current->kind));
     }
 }
 
-std::shared_ptr<ASTNode> Parser::assignment() {
-    std::string var = current_token.value;
-    eat("ID");
-    eat("ASSIGN");
-    auto expr_node = expr();
-    return std::make_shared<ASTNode>("ASSIGN", var, std::vector<std::shared_ptr<ASTNode>>{expr_node});
-} 
\ No newline at end of file
+NodeId Parser::assignment() {
+    uint32_t var = intern_name();
+    eat(TokenKind::ID);
+    if (at(TokenKind::LBRACKET)) {
+        eat(TokenKind::LBRACKET);
+        NodeId index = expr();
+        eat(TokenKind::RBRACKET);
+        eat(TokenKind::ASSIGN);
+        NodeId expr_node = expr();
+        return ast.add(NodeKind::INDEX_ASSIGN, var, {index, expr_node});
+    }
+    eat(TokenKind::ASSIGN);
+    NodeId expr_node = expr();
+    return ast.add(NodeKind::ASSIGN, var, {expr_node});
+}
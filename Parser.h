@@ -1,34 +1,53 @@
 #ifndef PARSER_H
 #define PARSER_H
 #include <vector>
-#include <memory>
 #include <string>
 #include "Token.h"
 #include "ASTNode.h"
 
+// Walks the lexer's token buffer in place; the vector must outlive the parser.
+// Nodes are appended to the AST passed in, whose root is set by parse().
 class Parser {
 public:
-    Parser(const std::vector<Token>& tokens);
-    std::shared_ptr<ASTNode> parse();
+    // Tokens [first, last) of one function definition.
+    struct Span {
+        size_t first;
+        size_t last;
+    };
+
+    Parser(const std::vector<Token>& tokens, AST& ast);
+    NodeId parse();
+    // The spans of the function definitions parsed, in order; empty for a
+    // top-level statement list.
+    const std::vector<Span>& function_spans() const { return spans; }
 private:
-    std::vector<Token> tokens;
-    size_t pos;
-    Token current_token;
-    void eat(const std::string& token_type);
-    std::shared_ptr<ASTNode> function_def();
-    std::shared_ptr<ASTNode> program();
-    std::shared_ptr<ASTNode> statement();
-    std::shared_ptr<ASTNode> declaration();
-    std::shared_ptr<ASTNode> for_stmt();
-    std::shared_ptr<ASTNode> return_stmt();
-    std::shared_ptr<ASTNode> while_stmt();
-    std::shared_ptr<ASTNode> if_stmt();
-    std::shared_ptr<ASTNode> condition();
-    std::shared_ptr<ASTNode> expr();
-    std::shared_ptr<ASTNode> term();
-    std::shared_ptr<ASTNode> factor();
-    std::shared_ptr<ASTNode> assignment();
+    const Token* begin;
+    const Token* current;
+    const Token* end;
+    static const Token eof_token;
+    AST& ast;
+    std::vector<NodeId> stack; // children collected for nodes under construction
+    std::vector<Span> spans;
+    size_t position() const { return current == &eof_token ? end - begin : current - begin; }
+    bool at(TokenKind kind) const { return current->kind == kind; }
+    void eat(TokenKind kind);
+    uint32_t intern_name() { return ast.names.intern(current->value); }
+    uint32_t intern_literal() { return ast.literals.intern(current->value); }
+    void block();
+    NodeId function_def();
+    NodeId program();
+    NodeId statement();
+    NodeId declaration();
+    NodeId for_stmt();
+    NodeId return_stmt();
+    NodeId while_stmt();
+    NodeId if_stmt();
+    NodeId condition();
+    NodeId expr();
+    NodeId term();
+    NodeId factor();
+    NodeId assignment();
     void advance();
 };
 
-#endif // PARSER_H 
\ No newline at end of file
+#endif // PARSER_H
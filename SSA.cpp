@@ -0,0 +1,124 @@
+#include "SSA.h"
+#include "Liveness.h"
+#include <utility>
+using namespace std;
+
+SSA::SSA(const TACFunction& f, const CFG& cfg, const DominatorTree& dom, bool pruned)
+    : block_phis(cfg.size()), def(f.code.size(), NO_VALUE),
+      use_a(f.code.size(), NO_VALUE), use_b(f.code.size(), NO_VALUE) {
+    if (cfg.size() == 0) return;
+    Liveness liveness(f, cfg);
+    size_t names = liveness.universe();
+
+    // Blocks assigning each candidate name; the entry block counts as
+    // assigning every name through its entry value. Pruned form only
+    // considers names live across blocks, numbered by their liveness slot.
+    auto candidate = [&](size_t name) {
+        return pruned ? liveness.slot(name) : static_cast<uint32_t>(name);
+    };
+    auto candidate_name = [&](uint32_t s) { return pruned ? liveness.globals[s] : s; };
+    vector<vector<BlockId>> def_blocks(pruned ? liveness.globals.size() : names);
+    for (BlockId b : dom.rpo) {
+        for (uint32_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; ++i) {
+            const TACInstr& in = f.code[i];
+            if (!in.has_dst()) continue;
+            uint32_t s = candidate(liveness.index(in.dst));
+            if (s == Liveness::NO_SLOT) continue;
+            if (def_blocks[s].empty() || def_blocks[s].back() != b) def_blocks[s].push_back(b);
+        }
+    }
+
+    // Phis at the iterated dominance frontier of the assignments (where the
+    // name is live on entry, when pruned).
+    vector<vector<BlockId>> df = dom.frontiers(cfg);
+    vector<uint32_t> placed(cfg.size(), UINT32_MAX), queued(cfg.size(), UINT32_MAX);
+    vector<BlockId> work;
+    for (uint32_t s = 0; s < def_blocks.size(); ++s) {
+        if (def_blocks[s].empty()) continue;
+        work = def_blocks[s];
+        work.push_back(0);
+        for (BlockId b : work) queued[b] = s;
+        while (!work.empty()) {
+            BlockId b = work.back();
+            work.pop_back();
+            for (BlockId d : df[b]) {
+                if (placed[d] == s || (pruned && !liveness.live_in[d].test(s))) continue;
+                placed[d] = s;
+                size_t args = cfg.blocks[d].preds.size() + (d == 0 ? 1 : 0);
+                block_phis[d].push_back(static_cast<uint32_t>(phis.size()));
+                phis.push_back(Phi{d, candidate_name(s), NO_VALUE, vector<ValueId>(args, NO_VALUE)});
+                if (queued[d] != s) {
+                    queued[d] = s;
+                    work.push_back(d);
+                }
+            }
+        }
+    }
+
+    // Renaming walks the dominator tree with the value currently reaching
+    // each name; leaving a block undoes its assignments from the log.
+    vector<ValueId> entry(names, NO_VALUE);
+    vector<ValueId> current(names, NO_VALUE);
+    auto reaching = [&](uint32_t name) {
+        if (current[name] != NO_VALUE) return current[name];
+        if (entry[name] == NO_VALUE) {
+            entry[name] = static_cast<ValueId>(values.size());
+            values.push_back(Value{Value::ENTRY, name, 0});
+        }
+        return entry[name];
+    };
+    vector<pair<uint32_t, ValueId>> undo;
+    auto assign = [&](uint32_t name, ValueId v) {
+        undo.push_back(make_pair(name, current[name]));
+        current[name] = v;
+    };
+    for (Phi& p : phis) {
+        p.value = static_cast<ValueId>(values.size());
+        values.push_back(Value{Value::PHI, static_cast<uint32_t>(&p - phis.data()), p.block});
+    }
+    for (uint32_t p : block_phis[0]) {
+        phis[p].args.back() = reaching(phis[p].name);
+    }
+
+    vector<pair<BlockId, size_t>> stack; // block, next child
+    vector<size_t> marks;                // undo log size on entering each block
+    stack.push_back(make_pair(BlockId(0), size_t(0)));
+    marks.push_back(0);
+    bool entering = true;
+    while (!stack.empty()) {
+        BlockId b = stack.back().first;
+        if (entering) {
+            for (uint32_t p : block_phis[b]) assign(phis[p].name, phis[p].value);
+            for (uint32_t i = cfg.blocks[b].begin; i < cfg.blocks[b].end; ++i) {
+                const TACInstr& in = f.code[i];
+                if (in.a.is_name()) use_a[i] = reaching(static_cast<uint32_t>(liveness.index(in.a)));
+                if (in.b.is_name()) use_b[i] = reaching(static_cast<uint32_t>(liveness.index(in.b)));
+                if (in.has_dst()) {
+                    def[i] = static_cast<ValueId>(values.size());
+                    values.push_back(Value{Value::INSTR, i, b});
+                    assign(static_cast<uint32_t>(liveness.index(in.dst)), def[i]);
+                }
+            }
+            for (BlockId s : cfg.blocks[b].succs) {
+                const vector<BlockId>& preds = cfg.blocks[s].preds;
+                for (size_t k = 0; k < preds.size(); ++k) {
+                    if (preds[k] != b) continue;
+                    for (uint32_t p : block_phis[s]) phis[p].args[k] = reaching(phis[p].name);
+                }
+            }
+        }
+        size_t& next = stack.back().second;
+        if (next < dom.children[b].size()) {
+            BlockId c = dom.children[b][next++];
+            stack.push_back(make_pair(c, size_t(0)));
+            marks.push_back(undo.size());
+            entering = true;
+        } else {
+            for (size_t k = undo.size(); k-- > marks.back();) current[undo[k].first] = undo[k].second;
+            undo.resize(marks.back());
+            marks.pop_back();
+            stack.pop_back();
+            entering = false;
+        }
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef SSA_H
+#define SSA_H
+#include <cstdint>
+#include <vector>
+#include "CFG.h"
+#include "Dominators.h"
+#include "TAC.h"
+
+typedef uint32_t ValueId;
+
+// SSA view of a function's code, built beside it rather than rewriting it:
+// every assignment defines a fresh value, every read of a name is linked to
+// the value that reaches it, and phi nodes merge values where control flow
+// joins. Each name also has an entry value standing for whatever it held
+// when the function started. By default phis are only placed where the name
+// is live (pruned SSA), which is all a pass reading values needs; a pass that
+// asks whether a name still holds some value wherever it is dead builds the
+// minimal form instead. Unreachable blocks get no values.
+class SSA {
+public:
+    static constexpr ValueId NO_VALUE = UINT32_MAX;
+
+    struct Value {
+        enum Kind : unsigned char { ENTRY, INSTR, PHI } kind;
+        uint32_t def;   // instruction index, phi index or name index for ENTRY
+        BlockId block;
+    };
+
+    // Incoming values are parallel to the block's preds; a phi in the entry
+    // block has one extra incoming value for the function entry itself.
+    struct Phi {
+        BlockId block;
+        uint32_t name;  // dense name index, see Liveness::index
+        ValueId value;
+        std::vector<ValueId> args;
+    };
+
+    SSA(const TACFunction& f, const CFG& cfg, const DominatorTree& dom, bool pruned = true);
+
+    std::vector<Value> values;
+    std::vector<Phi> phis;
+    std::vector<std::vector<uint32_t>> block_phis; // per block, indices into phis
+    std::vector<ValueId> def;                      // per instruction, NO_VALUE if it has no dst
+    std::vector<ValueId> use_a;                    // per instruction, value read through operand a
+    std::vector<ValueId> use_b;
+};
+
+#endif // SSA_H
@@ -1,54 +1,119 @@
 #include "SemanticAnalyzer.h"
-#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
 
-SemanticAnalyzer::SemanticAnalyzer(const std::shared_ptr<ASTNode>& parse_tree_)
-    : parse_tree(parse_tree_) {}
+// A literal's value, saturated past what any length or index can be.
+static int64_t literal_value(std::string_view text) {
+    int64_t v = 0;
+    for (char c : text) v = std::min<int64_t>(v * 10 + (c - '0'), INT64_C(1) << 32);
+    return v;
+}
+
+SemanticAnalyzer::SemanticAnalyzer(const AST& ast_)
+    : ASTVisitor(ast_) {}
 
 SymbolTable SemanticAnalyzer::analyze() {
-    visit(parse_tree);
-    return symbol_table;
-}
-
-void SemanticAnalyzer::visit(const std::shared_ptr<ASTNode>& node) {
-    if (!node) return;
-    if (node->type == "FUNCTION") {
-        for (const auto& child : node->children) {
-            visit(child);
-        }
-    } else if (node->type == "PROGRAM") {
-        for (const auto& child : node->children) {
-            visit(child);
-        }
-    } else if (node->type == "DECL") {
-        std::string var = node->value;
-        if (!node->children.empty()) {
-            visit(node->children[0]);
-        }
-        symbol_table.table[var] = "int";
-    } else if (node->type == "ASSIGN") {
-        std::string var = node->value;
-        auto expr = node->children[0];
-        visit(expr);
-        symbol_table.table[var] = "int"; // Assume all variables are int
-    } else if (node->type == "BINOP") {
-        visit(node->children[0]);
-        visit(node->children[1]);
-    } else if (node->type == "RELOP") {
-        visit(node->children[0]);
-        visit(node->children[1]);
-    } else if (node->type == "WHILE" || node->type == "IF" || node->type == "FOR") {
-        for (const auto& child : node->children) {
-            visit(child);
-        }
-    } else if (node->type == "BODY" || node->type == "THEN" || node->type == "ELSE") {
-        for (const auto& child : node->children) {
-            visit(child);
-        }
-    } else if (node->type == "RETURN") {
-        visit(node->children[0]);
-    } else if (node->type == "NUMBER" || node->type == "ID") {
-        // Nothing to do for leaves
-    } else {
-        std::cout << "[SemanticAnalyzer] Unhandled node type: " << node->type << std::endl;
+    symbol_table.reset_names(ast.names.size());
+    symbol_table.resolution.assign(ast.node_count(), SymbolTable::NO_VAR);
+    if (ast.node_count() > 0) visit(ast.root);
+    return std::move(symbol_table);
+}
+
+// A program made of function definitions is only a list of them; each
+// function opens its own scopes.
+void SemanticAnalyzer::visit_program(NodeId id) {
+    AST::ChildRange children = ast.children(id);
+    if (!children.empty() && ast.node(children[0]).kind == NodeKind::FUNCTION) {
+        visit_children(id);
+        return;
     }
-} 
\ No newline at end of file
+    symbol_table.begin_function();
+    scoped(id);
+}
+
+void SemanticAnalyzer::scoped(NodeId id) {
+    symbol_table.enter_scope();
+    visit_children(id);
+    symbol_table.exit_scope();
+}
+
+// FOR(init, WHILE(cond, BODY(stmts..., update))): the init variable lives in
+// a scope around the loop, and the update belongs to that scope rather than
+// the body's, so a body declaration cannot capture it.
+void SemanticAnalyzer::visit_for(NodeId id) {
+    AST::ChildRange parts = ast.children(id);
+    AST::ChildRange loop = ast.children(parts[1]);
+    AST::ChildRange body = ast.children(loop[1]);
+    symbol_table.enter_scope();
+    visit(parts[0]);
+    visit(loop[0]);
+    symbol_table.enter_scope();
+    for (size_t i = 0; i + 1 < body.size(); ++i) visit(body[i]);
+    symbol_table.exit_scope();
+    visit(body[body.size() - 1]);
+    symbol_table.exit_scope();
+}
+
+void SemanticAnalyzer::visit_decl(NodeId id) {
+    visit_children(id);
+    const ASTNode& node = ast.node(id);
+    VarId var = symbol_table.declare(node.value, ast.text(id));
+    if (symbol_table.symbols[var].length != 0) throw std::runtime_error("Conflicting declarations of " + std::string(ast.text(id)));
+    symbol_table.resolution[id] = var;
+}
+
+void SemanticAnalyzer::visit_assign(NodeId id) {
+    visit_children(id);
+    const ASTNode& node = ast.node(id);
+    symbol_table.resolution[id] = scalar(id, symbol_table.lookup_or_declare(node.value, ast.text(id)));
+}
+
+void SemanticAnalyzer::visit_id(NodeId id) {
+    const ASTNode& node = ast.node(id);
+    symbol_table.resolution[id] = scalar(id, symbol_table.lookup_or_declare(node.value, ast.text(id)));
+}
+
+VarId SemanticAnalyzer::scalar(NodeId id, VarId var) const {
+    if (symbol_table.symbols[var].length != 0) throw std::runtime_error("Array " + std::string(ast.text(id)) + " used without an index");
+    return var;
+}
+
+void SemanticAnalyzer::visit_array_decl(NodeId id) {
+    const ASTNode& node = ast.node(id);
+    std::string name(ast.text(id));
+    int64_t length = literal_value(ast.text(ast.children(id)[0]));
+    if (length < 1 || length > MAX_ARRAY_LENGTH) {
+        throw std::runtime_error("Array " + name + " has length " + std::string(ast.text(ast.children(id)[0]))
+                                 + "; it must be 1 to " + std::to_string(MAX_ARRAY_LENGTH));
+    }
+    VarId var = symbol_table.declare(node.value, name, static_cast<int32_t>(length));
+    if (symbol_table.symbols[var].length != length) throw std::runtime_error("Conflicting declarations of " + name);
+    symbol_table.resolution[id] = var;
+}
+
+// The array an INDEX or INDEX_ASSIGN names; a constant index is checked
+// against its length here, other indexes when the code runs.
+VarId SemanticAnalyzer::array(NodeId id) const {
+    std::string name(ast.text(id));
+    VarId var = symbol_table.lookup(ast.node(id).value);
+    if (var == SymbolTable::NO_VAR) throw std::runtime_error("Undeclared array " + name);
+    const Symbol& symbol = symbol_table.symbols[var];
+    if (symbol.length == 0) throw std::runtime_error(name + " is not an array");
+    NodeId index = ast.children(id)[0];
+    if (ast.node(index).kind == NodeKind::NUMBER && literal_value(ast.text(index)) >= symbol.length) {
+        throw std::runtime_error("Index " + std::string(ast.text(index)) + " out of range for " + name + symbol.type.substr(3));
+    }
+    return var;
+}
+
+void SemanticAnalyzer::visit_index(NodeId id) {
+    visit_children(id);
+    symbol_table.resolution[id] = array(id);
+}
+
+void SemanticAnalyzer::visit_index_assign(NodeId id) {
+    visit_children(id);
+    symbol_table.resolution[id] = array(id);
+}
@@ -1,17 +1,35 @@
 #ifndef SEMANTICANALYZER_H
 #define SEMANTICANALYZER_H
-#include "ASTNode.h"
+#include "ASTVisitor.h"
 #include "SymbolTable.h"
-#include <memory>
 
-class SemanticAnalyzer {
+// Resolves every variable reference to a VarId. Functions and the bodies of
+// while/if/else/for open nested scopes; names used without a declaration are
+// implicitly declared as function-scope ints. Arrays must be declared, with a
+// constant length, before they are indexed, and are only used indexed; a
+// misuse, or a constant index outside the array, throws.
+class SemanticAnalyzer : private ASTVisitor<SemanticAnalyzer> {
 public:
-    SemanticAnalyzer(const std::shared_ptr<ASTNode>& parse_tree);
+    SemanticAnalyzer(const AST& ast);
     SymbolTable analyze();
 private:
-    std::shared_ptr<ASTNode> parse_tree;
+    friend class ASTVisitor<SemanticAnalyzer>;
     SymbolTable symbol_table;
-    void visit(const std::shared_ptr<ASTNode>& node);
+    void scoped(NodeId id);
+    void visit_program(NodeId id);
+    void visit_function(NodeId id) { symbol_table.begin_function(); scoped(id); }
+    void visit_body(NodeId id) { scoped(id); }
+    void visit_then(NodeId id) { scoped(id); }
+    void visit_else(NodeId id) { scoped(id); }
+    void visit_for(NodeId id);
+    void visit_decl(NodeId id);
+    void visit_assign(NodeId id);
+    void visit_id(NodeId id);
+    void visit_array_decl(NodeId id);
+    void visit_index(NodeId id);
+    void visit_index_assign(NodeId id);
+    VarId scalar(NodeId id, VarId var) const;
+    VarId array(NodeId id) const;
 };
 
-#endif // SEMANTICANALYZER_H 
\ No newline at end of file
+#endif // SEMANTICANALYZER_H
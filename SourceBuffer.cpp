@@ -0,0 +1,51 @@
+#include "SourceBuffer.h"
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+SourceBuffer::SourceBuffer(const string& filename) : data(""), size(0), mapped(false) {
+#ifndef _WIN32
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error("Cannot open file: " + filename);
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            madvise(p, st.st_size, MADV_SEQUENTIAL);
+            data = static_cast<const char*>(p);
+            size = st.st_size;
+            mapped = true;
+        }
+    }
+    close(fd);
+    if (mapped) return;
+#endif
+    ifstream file(filename, ios::binary);
+    if (!file) {
+        throw runtime_error("Cannot open file: " + filename);
+    }
+    owned.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    data = owned.data();
+    size = owned.size();
+}
+
+SourceBuffer::SourceBuffer(Text text) : mapped(false), owned(move(text.contents)) {
+    data = owned.data();
+    size = owned.size();
+}
+
+SourceBuffer::~SourceBuffer() {
+#ifndef _WIN32
+    if (mapped) munmap(const_cast<char*>(data), size);
+#endif
+}
@@ -0,0 +1,29 @@
+#ifndef SOURCEBUFFER_H
+#define SOURCEBUFFER_H
+#include <string>
+#include <string_view>
+
+// Read-only view of a source file. Regular files are memory-mapped so the
+// lexer can scan them in place; anything that cannot be mapped is read into
+// an owned string instead. Source text already in memory is taken over as is.
+class SourceBuffer {
+public:
+    struct Text {
+        std::string contents;
+    };
+
+    explicit SourceBuffer(const std::string& filename);
+    explicit SourceBuffer(Text text);
+    ~SourceBuffer();
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+    std::string_view view() const { return std::string_view(data, size); }
+    bool is_mapped() const { return mapped; }
+private:
+    const char* data;
+    size_t size;
+    bool mapped;
+    std::string owned;
+};
+
+#endif // SOURCEBUFFER_H
@@ -0,0 +1,27 @@
+#include "StringInterner.h"
+#include <cstring>
+using namespace std;
+
+uint32_t StringInterner::intern(string_view text) {
+    auto it = ids.find(text);
+    if (it != ids.end()) return it->second;
+    char* copy = static_cast<char*>(storage.allocate(text.size() + 1, 1));
+    memcpy(copy, text.data(), text.size());
+    copy[text.size()] = '\0';
+    string_view stored(copy, text.size());
+    uint32_t id = static_cast<uint32_t>(strings.size());
+    strings.push_back(stored);
+    ids.emplace(stored, id);
+    return id;
+}
+
+size_t StringInterner::memory_bytes() const {
+    return storage.bytes_reserved() + strings.capacity() * sizeof(string_view)
+        + ids.size() * (sizeof(string_view) + sizeof(uint32_t) + 2 * sizeof(void*));
+}
+
+void StringInterner::clear() {
+    unordered_map<string_view, uint32_t>().swap(ids);
+    vector<string_view>().swap(strings);
+    storage.reset();
+}
@@ -0,0 +1,25 @@
+#ifndef STRINGINTERNER_H
+#define STRINGINTERNER_H
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Arena.h"
+
+// Maps each distinct string to a dense id, assigned in first-seen order.
+// The bytes live in an arena, so views returned by str() stay valid for the
+// interner's lifetime.
+class StringInterner {
+public:
+    uint32_t intern(std::string_view text);
+    std::string_view str(uint32_t id) const { return strings[id]; }
+    size_t size() const { return strings.size(); }
+    size_t memory_bytes() const;
+    void clear();
+private:
+    Arena storage;
+    std::vector<std::string_view> strings;
+    std::unordered_map<std::string_view, uint32_t> ids;
+};
+
+#endif // STRINGINTERNER_H
@@ -1,16 +1,75 @@
 #include "SymbolTable.h"
+#include <cctype>
 #include <sstream>
 using namespace std;
 
+// TAC spells temporaries tN and labels LN; variables may not look like either.
+static bool is_reserved(string_view name) {
+    if (name.size() < 2 || (name[0] != 't' && name[0] != 'L')) return false;
+    for (size_t i = 1; i < name.size(); ++i) {
+        if (!isdigit(static_cast<unsigned char>(name[i]))) return false;
+    }
+    return true;
+}
+
+void SymbolTable::reset_names(size_t identifier_count) {
+    binding.assign(identifier_count, NO_VAR);
+    scopes.clear();
+    taken.clear();
+}
+
+void SymbolTable::begin_function() {
+    while (!scopes.empty()) exit_scope();
+    taken.clear();
+}
+
+void SymbolTable::enter_scope() {
+    scopes.emplace_back();
+}
+
+void SymbolTable::exit_scope() {
+    for (VarId var : scopes.back()) {
+        binding[symbols[var].name_id] = symbols[var].shadows;
+    }
+    scopes.pop_back();
+}
+
+VarId SymbolTable::add(uint32_t name_id, string_view name, int depth, VarId shadows, int32_t length) {
+    // A variable that shadows another one of the same name (or reuses a name
+    // from a closed scope) gets a suffixed TAC name so the two stay distinct.
+    string unique(name);
+    for (int n = 1; taken.count(unique) || is_reserved(unique); ++n) unique = string(name) + "_" + to_string(n);
+    taken.insert(unique);
+    VarId var = static_cast<VarId>(symbols.size());
+    string type = length > 0 ? "int[" + to_string(length) + "]" : "int";
+    symbols.push_back(Symbol{name_id, unique, type, depth, shadows, length});
+    binding[name_id] = var;
+    scopes[depth].push_back(var);
+    return var;
+}
+
+VarId SymbolTable::declare(uint32_t name_id, string_view name, int32_t length) {
+    if (scopes.empty()) enter_scope();
+    int depth = static_cast<int>(scopes.size()) - 1;
+    VarId current = binding[name_id];
+    if (current != NO_VAR && symbols[current].depth == depth) return current;
+    return add(name_id, name, depth, current, length);
+}
+
+VarId SymbolTable::lookup_or_declare(uint32_t name_id, string_view name) {
+    if (scopes.empty()) enter_scope();
+    VarId current = binding[name_id];
+    if (current != NO_VAR) return current;
+    return add(name_id, name, 0, NO_VAR, 0);
+}
+
 string SymbolTable::repr() const {
     ostringstream oss;
     oss << "{";
-    bool first = true;
-    for (const auto& kv : table) {
-        if (!first) oss << ", ";
-        oss << kv.first << ": " << kv.second;
-        first = false;
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        if (i > 0) oss << ", ";
+        oss << symbols[i].name << ": " << symbols[i].type;
     }
     oss << "}";
     return oss.str();
-} 
\ No newline at end of file
+}
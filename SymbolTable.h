@@ -1,13 +1,57 @@
 #ifndef SYMBOLTABLE_H
 #define SYMBOLTABLE_H
+#include <cstdint>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
 
+typedef uint32_t VarId;
+
+// Most elements an array may have, which keeps its size in bytes an int32.
+const int32_t MAX_ARRAY_LENGTH = 1 << 20;
+
+struct Symbol {
+    uint32_t name_id;  // identifier id from the AST's name interner
+    std::string name;  // unique within its function; used in TAC
+    std::string type;  // "int" or "int[length]"
+    int depth;         // 0 = function scope
+    VarId shadows;     // binding restored when this symbol's scope closes
+    int32_t length;    // elements of an array, 0 for an int
+};
+
+// Variables are numbered densely in declaration order, so later stages can
+// key flat arrays and bitsets by VarId. Name lookup goes through a binding
+// array indexed by identifier id rather than hashing strings.
 class SymbolTable {
 public:
-    std::unordered_map<std::string, std::string> table;
+    static constexpr VarId NO_VAR = UINT32_MAX;
+
+    std::vector<Symbol> symbols;   // indexed by VarId
+    std::vector<VarId> resolution; // VarId of each DECL/ASSIGN/ID node, indexed by NodeId
+
     SymbolTable() = default;
+    void reset_names(size_t identifier_count);
+    void begin_function();
+    void enter_scope();
+    void exit_scope();
+    // Declares an int, or an array of length elements, in the innermost
+    // scope; a repeated declaration in the same scope refers to the existing
+    // variable, whatever its length.
+    VarId declare(uint32_t name_id, std::string_view name, int32_t length = 0);
+    // Innermost visible variable, or NO_VAR.
+    VarId lookup(uint32_t name_id) const { return binding[name_id]; }
+    // Innermost visible variable, or an implicit function-scope int.
+    VarId lookup_or_declare(uint32_t name_id, std::string_view name);
+    VarId var_of(uint32_t node) const { return resolution[node]; }
+    const std::string& name(VarId var) const { return symbols[var].name; }
+    size_t size() const { return symbols.size(); }
     std::string repr() const;
+private:
+    std::vector<VarId> binding;                // identifier id -> visible VarId
+    std::vector<std::vector<VarId>> scopes;    // variables declared per open scope
+    std::unordered_set<std::string> taken;     // TAC names used in the current function
+    VarId add(uint32_t name_id, std::string_view name, int depth, VarId shadows, int32_t length);
 };
 
-#endif // SYMBOLTABLE_H 
\ No newline at end of file
+#endif // SYMBOLTABLE_H
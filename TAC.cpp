@@ -0,0 +1,80 @@
+#include "TAC.h"
+using namespace std;
+
+const char* tac_op_name(TACOp op) {
+    static const char* const names[] = {
+        "=", "+", "-", "*", "/", "<<", ">>", "LT", "GT", "LE", "GE", "EQ", "NE",
+        "load", "store", "vload", "vstore", "v+", "v-", "v*", "vsplat", "vsum",
+        "label", "goto", "ifFalse", "return"
+    };
+    return names[static_cast<int>(op)];
+}
+
+int32_t fold_binary(TACOp op, int32_t a, int32_t b) {
+    uint32_t ua = static_cast<uint32_t>(a), ub = static_cast<uint32_t>(b);
+    switch (op) {
+        case TACOp::ADD: return static_cast<int32_t>(ua + ub);
+        case TACOp::SUB: return static_cast<int32_t>(ua - ub);
+        case TACOp::MUL: return static_cast<int32_t>(ua * ub);
+        case TACOp::DIV:
+            if (b == 0) return 0;
+            if (a == INT32_MIN && b == -1) return INT32_MIN;
+            return a / b;
+        case TACOp::SHL: return static_cast<int32_t>(ua << (ub & 31));
+        case TACOp::SHR: return a >> (ub & 31);
+        case TACOp::LT: return a < b;
+        case TACOp::GT: return a > b;
+        case TACOp::LE: return a <= b;
+        case TACOp::GE: return a >= b;
+        case TACOp::EQ: return a == b;
+        case TACOp::NE: return a != b;
+        default: return 0;
+    }
+}
+
+string TACFunction::operand_str(const Operand& o) const {
+    switch (o.kind) {
+        case Operand::VAR:   return vars[o.value];
+        case Operand::TEMP:  return "t" + to_string(o.value);
+        case Operand::CONST: return to_string(o.value);
+        default:             return "";
+    }
+}
+
+string TACFunction::instr_str(const TACInstr& in) const {
+    switch (in.op) {
+        case TACOp::COPY:
+            return operand_str(in.dst) + " = " + operand_str(in.a);
+        case TACOp::LABEL:
+            return "L" + to_string(in.label) + ":";
+        case TACOp::GOTO:
+            return "goto L" + to_string(in.label);
+        case TACOp::IF_FALSE:
+            return "ifFalse " + operand_str(in.a) + " goto L" + to_string(in.label);
+        case TACOp::RETURN:
+            return "return " + operand_str(in.a);
+        case TACOp::LOAD:
+            return operand_str(in.dst) + " = " + arrays[in.label].name + "[" + operand_str(in.a) + "]";
+        case TACOp::STORE:
+            return arrays[in.label].name + "[" + operand_str(in.a) + "] = " + operand_str(in.b);
+        case TACOp::VLOAD:
+            return operand_str(in.dst) + " = vload " + arrays[in.label].name + "[" + operand_str(in.a) + "]";
+        case TACOp::VSTORE:
+            return "vstore " + arrays[in.label].name + "[" + operand_str(in.a) + "] = " + operand_str(in.b);
+        case TACOp::VSPLAT:
+        case TACOp::VSUM:
+            return operand_str(in.dst) + " = " + tac_op_name(in.op) + " " + operand_str(in.a);
+        default:
+            return operand_str(in.dst) + " = " + operand_str(in.a) + " " + tac_op_name(in.op) + " " + operand_str(in.b);
+    }
+}
+
+vector<string> tac_lines(const TACProgram& program) {
+    vector<string> lines;
+    for (const auto& f : program.functions) {
+        if (f.has_header) lines.push_back("function " + f.name + ":");
+        for (const auto& in : f.code) lines.push_back(f.instr_str(in));
+        if (f.has_header) lines.push_back("end function " + f.name);
+    }
+    return lines;
+}
@@ -0,0 +1,140 @@
+#ifndef TAC_H
+#define TAC_H
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class TACOp : unsigned char {
+    COPY,                    // dst = a
+    ADD, SUB, MUL, DIV,      // dst = a op b
+    SHL, SHR,                // dst = a << b, a >> b (arithmetic); b taken mod 32
+    LT, GT, LE, GE, EQ, NE,  // dst = a REL b, 1 or 0
+    LOAD,                    // dst = array<label>[a]
+    STORE,                   // array<label>[a] = b
+    VLOAD,                   // dst = array<label>[a .. a + width - 1]
+    VSTORE,                  // array<label>[a .. a + width - 1] = b
+    VADD, VSUB, VMUL,        // dst = a op b, lane by lane
+    VSPLAT,                  // dst = a in every lane
+    VSUM,                    // dst = the sum of a's lanes
+    LABEL,                   // L<label>:
+    GOTO,                    // goto L<label>
+    IF_FALSE,                // ifFalse a goto L<label>
+    RETURN,                  // return a
+    COUNT
+};
+
+// An array element outside the array reads as 0 and is not written. The V
+// ops work on vectors of the function's vector_width lanes, held in
+// temporaries that hold nothing but vectors.
+const int MAX_VECTOR_WIDTH = 16;
+
+const char* tac_op_name(TACOp op); // "+", "LT", ... for binary ops
+
+inline bool is_binary(TACOp op) { return op >= TACOp::ADD && op <= TACOp::NE; }
+inline bool is_arith(TACOp op) { return op >= TACOp::ADD && op <= TACOp::SHR; }
+inline bool is_relational(TACOp op) { return op >= TACOp::LT && op <= TACOp::NE; }
+inline bool is_memory(TACOp op) { return op >= TACOp::LOAD && op <= TACOp::VSTORE; }
+inline bool is_vector(TACOp op) { return op >= TACOp::VLOAD && op <= TACOp::VSUM; }
+inline bool is_control_or_label(TACOp op) { return op >= TACOp::LABEL; }
+
+// Which operands of op hold vectors: 1 for dst, 2 for a, 4 for b.
+inline unsigned vector_operands(TACOp op) {
+    switch (op) {
+        case TACOp::VLOAD:
+        case TACOp::VSPLAT: return 1;
+        case TACOp::VSTORE: return 4;
+        case TACOp::VADD:
+        case TACOp::VSUB:
+        case TACOp::VMUL:   return 7;
+        case TACOp::VSUM:   return 2;
+        default:            return 0;
+    }
+}
+
+// Evaluates a binary op on 32-bit ints the way generated code does:
+// arithmetic wraps and division by zero yields 0.
+int32_t fold_binary(TACOp op, int32_t a, int32_t b);
+
+struct Operand {
+    enum Kind : unsigned char { NONE, VAR, TEMP, CONST };
+    Kind kind;
+    int32_t value; // function-local variable id, temporary number or constant
+
+    static Operand none() { return Operand{NONE, 0}; }
+    static Operand var(int32_t id) { return Operand{VAR, id}; }
+    static Operand temp(int32_t n) { return Operand{TEMP, n}; }
+    static Operand constant(int32_t v) { return Operand{CONST, v}; }
+    bool is_const() const { return kind == CONST; }
+    bool is_name() const { return kind == VAR || kind == TEMP; }
+    bool operator==(const Operand& o) const { return kind == o.kind && value == o.value; }
+    bool operator!=(const Operand& o) const { return !(*this == o); }
+    bool operator<(const Operand& o) const { return kind != o.kind ? kind < o.kind : value < o.value; }
+};
+
+struct OperandHash {
+    size_t operator()(const Operand& o) const {
+        return (static_cast<size_t>(o.kind) << 32) ^ static_cast<uint32_t>(o.value);
+    }
+};
+
+struct TACInstr {
+    TACOp op;
+    Operand dst;
+    Operand a;
+    Operand b;
+    int32_t label; // LABEL, GOTO and IF_FALSE; the array of a load or store
+
+    static TACInstr copy(Operand dst, Operand a) { return TACInstr{TACOp::COPY, dst, a, Operand::none(), 0}; }
+    static TACInstr binary(TACOp op, Operand dst, Operand a, Operand b) { return TACInstr{op, dst, a, b, 0}; }
+    static TACInstr label_def(int32_t l) { return TACInstr{TACOp::LABEL, Operand::none(), Operand::none(), Operand::none(), l}; }
+    static TACInstr jump(int32_t l) { return TACInstr{TACOp::GOTO, Operand::none(), Operand::none(), Operand::none(), l}; }
+    static TACInstr if_false(Operand cond, int32_t l) { return TACInstr{TACOp::IF_FALSE, Operand::none(), cond, Operand::none(), l}; }
+    static TACInstr ret(Operand a) { return TACInstr{TACOp::RETURN, Operand::none(), a, Operand::none(), 0}; }
+    static TACInstr unary(TACOp op, Operand dst, Operand a) { return TACInstr{op, dst, a, Operand::none(), 0}; }
+    static TACInstr load(TACOp op, Operand dst, int32_t array, Operand index) {
+        return TACInstr{op, dst, index, Operand::none(), array};
+    }
+    static TACInstr store(TACOp op, int32_t array, Operand index, Operand value) {
+        return TACInstr{op, Operand::none(), index, value, array};
+    }
+    bool has_dst() const { return dst.kind != Operand::NONE; }
+    bool operator==(const TACInstr& o) const {
+        return op == o.op && dst == o.dst && a == o.a && b == o.b && label == o.label;
+    }
+    bool operator!=(const TACInstr& o) const { return !(*this == o); }
+};
+
+struct TACArray {
+    std::string name;
+    int32_t length;
+};
+
+// One function's code. Variables are numbered locally so a function can be
+// optimized, cached or executed without the rest of the program; arrays, like
+// variables, start out zeroed on every call.
+struct TACFunction {
+    std::string name;
+    bool has_header = true;         // false for a top-level statement list
+    std::vector<std::string> vars;  // local variable id -> name
+    std::vector<TACArray> arrays;   // local array id -> name and length
+    int32_t temp_count = 0;         // highest temporary number in use
+    int32_t label_count = 0;        // highest label number in use
+    int32_t vector_width = 1;       // lanes of the V ops
+    std::vector<TACInstr> code;
+    std::vector<int32_t> unrolled;  // header labels of loops the unroller produced or left as remainders
+    std::vector<int32_t> vectorized; // header labels of loops the vectorizer produced or left as epilogues
+
+    Operand new_temp() { return Operand::temp(++temp_count); }
+    int32_t new_label() { return ++label_count; }
+    std::string operand_str(const Operand& o) const;
+    std::string instr_str(const TACInstr& in) const;
+};
+
+struct TACProgram {
+    std::vector<TACFunction> functions;
+};
+
+// The textual listing written to tac.txt and optimized_output.txt.
+std::vector<std::string> tac_lines(const TACProgram& program);
+
+#endif // TAC_H
@@ -1,99 +1,226 @@
 #include "TACGenerator.h"
-#include <iostream>
+#include <algorithm>
 using namespace std;
 
-TACGenerator::TACGenerator(const shared_ptr<ASTNode>& parse_tree_, const SymbolTable& symbol_table_)
-    : parse_tree(parse_tree_), symbol_table(symbol_table_), temp_count(0), label_count(0) {}
-
-string TACGenerator::new_temp() {
-    temp_count++;
-    return "t" + to_string(temp_count);
-}
-
-string TACGenerator::new_label() {
-    label_count++;
-    return "L" + to_string(label_count);
-}
-
-vector<string> TACGenerator::generate() {
-    visit(parse_tree);
-    return tac;
-}
-
-string TACGenerator::visit(const shared_ptr<ASTNode>& node) {
-    if (!node) return "";
-    if (node->type == "FUNCTION") {
-        tac.push_back("function " + node->value + ":");
-        for (const auto& child : node->children) {
-            visit(child);
-        }
-        tac.push_back("end function " + node->value);
-    } else if (node->type == "PROGRAM") {
-        for (const auto& child : node->children) {
-            visit(child);
-        }
-    } else if (node->type == "DECL") {
-        string var = node->value;
-        if (!node->children.empty()) {
-            string res = visit(node->children[0]);
-            tac.push_back(var + " = " + res);
-        }
-    } else if (node->type == "ASSIGN") {
-        string var = node->value;
-        auto expr = node->children[0];
-        string res = visit(expr);
-        tac.push_back(var + " = " + res);
-    } else if (node->type == "BINOP") {
-        string left = visit(node->children[0]);
-        string right = visit(node->children[1]);
-        string temp = new_temp();
-        tac.push_back(temp + " = " + left + " " + node->value + " " + right);
-        return temp;
-    } else if (node->type == "RELOP") {
-        string left = visit(node->children[0]);
-        string right = visit(node->children[1]);
-        string temp = new_temp();
-        tac.push_back(temp + " = " + left + " " + node->value + " " + right);
-        return temp;
-    } else if (node->type == "WHILE") {
-        string start_label = new_label();
-        string end_label = new_label();
-        tac.push_back(start_label + ":");
-        string cond = visit(node->children[0]);
-        tac.push_back("ifFalse " + cond + " goto " + end_label);
-        if (node->children[1]->type == "BODY") {
-            for (const auto& stmt : node->children[1]->children) {
-                visit(stmt);
-            }
-        } else {
-            visit(node->children[1]);
-        }
-        tac.push_back("goto " + start_label);
-        tac.push_back(end_label + ":");
-    } else if (node->type == "FOR") {
-        visit(node->children[0]); // init
-        visit(node->children[1]); // desugared while
-    } else if (node->type == "IF") {
-        string else_label = new_label();
-        string end_label = new_label();
-        string cond = visit(node->children[0]);
-        tac.push_back("ifFalse " + cond + " goto " + else_label);
-        visit(node->children[1]); // THEN
-        tac.push_back("goto " + end_label);
-        tac.push_back(else_label + ":");
-        visit(node->children[2]); // ELSE
-        tac.push_back(end_label + ":");
-    } else if (node->type == "BODY" || node->type == "THEN" || node->type == "ELSE") {
-        for (const auto& child : node->children) {
-            visit(child);
-        }
-    } else if (node->type == "RETURN") {
-        string res = visit(node->children[0]);
-        tac.push_back("return " + res);
-    } else if (node->type == "NUMBER" || node->type == "ID") {
-        return node->value;
+static TACOp op_from_text(string_view text) {
+    switch (text[0]) {
+        case '+': return TACOp::ADD;
+        case '-': return TACOp::SUB;
+        case '*': return TACOp::MUL;
+        case '/': return TACOp::DIV;
+        case 'L': return text[1] == 'T' ? TACOp::LT : TACOp::LE;
+        case 'G': return text[1] == 'T' ? TACOp::GT : TACOp::GE;
+        case 'E': return TACOp::EQ;
+        default:  return TACOp::NE;
+    }
+}
+
+// Literals wrap to 32 bits like the arithmetic on them.
+static int32_t parse_literal(string_view text) {
+    uint32_t v = 0;
+    for (char c : text) v = v * 10 + static_cast<uint32_t>(c - '0');
+    return static_cast<int32_t>(v);
+}
+
+// Children are added before their parent, so one pass in id order numbers
+// every expression: a leaf needs no temporary, and an operator needs one more
+// than its children when both need the same, else as many as the larger. An
+// element read needs one for its value, which may reuse its index's.
+TACGenerator::TACGenerator(const AST& ast_, const SymbolTable& symbol_table_)
+    : ASTVisitor(ast_), symbol_table(symbol_table_), fn(nullptr), need(ast_.node_count(), 0) {
+    for (NodeId id = 0; id < ast.node_count(); ++id) {
+        NodeKind kind = ast.node(id).kind;
+        AST::ChildRange children = ast.children(id);
+        if (kind == NodeKind::INDEX) need[id] = max<uint32_t>(need[children[0]], 1);
+        if (kind != NodeKind::BINOP && kind != NodeKind::RELOP) continue;
+        uint32_t l = need[children[0]], r = need[children[1]];
+        need[id] = l == r ? l + 1 : max(l, r);
+    }
+}
+
+// Temporaries and labels are numbered per function, so a function's code
+// depends on nothing but its own source. A temporary is read once, by the
+// instruction that consumes the expression it holds, and goes back on the
+// free list there, so a function uses as many temporaries as its largest
+// expression needs.
+Operand TACGenerator::new_temp() {
+    if (free_temps.empty()) return fn->new_temp();
+    Operand t = Operand::temp(free_temps.back());
+    free_temps.pop_back();
+    return t;
+}
+
+void TACGenerator::release(const Operand& o) {
+    if (o.kind == Operand::TEMP) free_temps.push_back(o.value);
+}
+
+int32_t TACGenerator::new_label() {
+    return fn->new_label();
+}
+
+TACProgram TACGenerator::generate() {
+    if (ast.node_count() > 0) visit(ast.root);
+    return std::move(program);
+}
+
+TACFunction TACGenerator::generate_function(NodeId id) {
+    program.functions.clear();
+    visit(id);
+    return std::move(program.functions.back());
+}
+
+void TACGenerator::begin_function(const string& name, bool has_header) {
+    program.functions.emplace_back();
+    fn = &program.functions.back();
+    fn->name = name;
+    fn->has_header = has_header;
+    local_id.assign(symbol_table.size(), -1);
+    free_temps.clear();
+}
+
+Operand TACGenerator::var(NodeId id) {
+    VarId v = symbol_table.var_of(id);
+    if (local_id[v] < 0) {
+        local_id[v] = static_cast<int32_t>(fn->vars.size());
+        fn->vars.push_back(symbol_table.name(v));
+    }
+    return Operand::var(local_id[v]);
+}
+
+int32_t TACGenerator::array(NodeId id) {
+    VarId v = symbol_table.var_of(id);
+    if (local_id[v] < 0) {
+        local_id[v] = static_cast<int32_t>(fn->arrays.size());
+        fn->arrays.push_back(TACArray{symbol_table.name(v), symbol_table.symbols[v].length});
+    }
+    return local_id[v];
+}
+
+Operand TACGenerator::visit_program(NodeId id) {
+    // A program made of function definitions has no top-level code.
+    AST::ChildRange children = ast.children(id);
+    if (children.empty() || ast.node(children[0]).kind != NodeKind::FUNCTION) begin_function("", false);
+    visit_children(id);
+    return Operand::none();
+}
+
+Operand TACGenerator::visit_function(NodeId id) {
+    begin_function(string(ast.text(id)), true);
+    visit_children(id);
+    return Operand::none();
+}
+
+Operand TACGenerator::visit_decl(NodeId id) {
+    AST::ChildRange children = ast.children(id);
+    if (!children.empty()) {
+        Operand res = visit(children[0]);
+        emit(TACInstr::copy(var(id), res));
+        release(res);
+    }
+    return Operand::none();
+}
+
+Operand TACGenerator::visit_assign(NodeId id) {
+    Operand res = visit(ast.children(id)[0]);
+    emit(TACInstr::copy(var(id), res));
+    release(res);
+    return Operand::none();
+}
+
+// The operand needing more temporaries is evaluated first, while none are
+// held, which expressions without side effects allow. Both operand
+// temporaries are free again once read, so the result may reuse one.
+Operand TACGenerator::visit_binop(NodeId id) {
+    AST::ChildRange children = ast.children(id);
+    Operand left, right;
+    if (need[children[1]] > need[children[0]]) {
+        right = visit(children[1]);
+        left = visit(children[0]);
+    } else {
+        left = visit(children[0]);
+        right = visit(children[1]);
+    }
+    release(right);
+    release(left);
+    Operand temp = new_temp();
+    emit(TACInstr::binary(op_from_text(ast.text(id)), temp, left, right));
+    return temp;
+}
+
+Operand TACGenerator::visit_relop(NodeId id) {
+    return visit_binop(id);
+}
+
+Operand TACGenerator::visit_number(NodeId id) {
+    return Operand::constant(parse_literal(ast.text(id)));
+}
+
+Operand TACGenerator::visit_id(NodeId id) {
+    return var(id);
+}
+
+Operand TACGenerator::visit_while(NodeId id) {
+    AST::ChildRange children = ast.children(id);
+    int32_t start_label = new_label();
+    int32_t end_label = new_label();
+    emit(TACInstr::label_def(start_label));
+    Operand cond = visit(children[0]);
+    emit(TACInstr::if_false(cond, end_label));
+    release(cond);
+    visit(children[1]); // BODY
+    emit(TACInstr::jump(start_label));
+    emit(TACInstr::label_def(end_label));
+    return Operand::none();
+}
+
+Operand TACGenerator::visit_if(NodeId id) {
+    AST::ChildRange children = ast.children(id);
+    int32_t else_label = new_label();
+    int32_t end_label = new_label();
+    Operand cond = visit(children[0]);
+    emit(TACInstr::if_false(cond, else_label));
+    release(cond);
+    visit(children[1]); // THEN
+    emit(TACInstr::jump(end_label));
+    emit(TACInstr::label_def(else_label));
+    visit(children[2]); // ELSE
+    emit(TACInstr::label_def(end_label));
+    return Operand::none();
+}
+
+Operand TACGenerator::visit_return(NodeId id) {
+    Operand res = visit(ast.children(id)[0]);
+    emit(TACInstr::ret(res));
+    release(res);
+    return Operand::none();
+}
+
+Operand TACGenerator::visit_array_decl(NodeId id) {
+    array(id);
+    return Operand::none();
+}
+
+Operand TACGenerator::visit_index(NodeId id) {
+    Operand index = visit(ast.children(id)[0]);
+    release(index);
+    Operand temp = new_temp();
+    emit(TACInstr::load(TACOp::LOAD, temp, array(id), index));
+    return temp;
+}
+
+// Index and value are evaluated in the order visit_binop would use.
+Operand TACGenerator::visit_index_assign(NodeId id) {
+    AST::ChildRange children = ast.children(id);
+    Operand index, value;
+    if (need[children[1]] > need[children[0]]) {
+        value = visit(children[1]);
+        index = visit(children[0]);
     } else {
-        cout << "[TACGenerator] Unhandled node type: " << node->type << endl;
+        index = visit(children[0]);
+        value = visit(children[1]);
     }
-    return "";
-} 
\ No newline at end of file
+    emit(TACInstr::store(TACOp::STORE, array(id), index, value));
+    release(value);
+    release(index);
+    return Operand::none();
+}
@@ -1,24 +1,45 @@
 #ifndef TACGENERATOR_H
 #define TACGENERATOR_H
-#include "ASTNode.h"
+#include "ASTVisitor.h"
 #include "SymbolTable.h"
+#include "TAC.h"
 #include <vector>
-#include <string>
-#include <memory>
 
-class TACGenerator {
+class TACGenerator : private ASTVisitor<TACGenerator, Operand> {
 public:
-    TACGenerator(const std::shared_ptr<ASTNode>& parse_tree, const SymbolTable& symbol_table);
-    std::vector<std::string> generate();
+    TACGenerator(const AST& ast, const SymbolTable& symbol_table);
+    TACProgram generate();
+    // The code of one FUNCTION node, or of a top-level statement list.
+    TACFunction generate_function(NodeId id);
 private:
-    std::shared_ptr<ASTNode> parse_tree;
-    SymbolTable symbol_table;
-    std::vector<std::string> tac;
-    int temp_count;
-    int label_count;
-    std::string new_temp();
-    std::string new_label();
-    std::string visit(const std::shared_ptr<ASTNode>& node);
+    friend class ASTVisitor<TACGenerator, Operand>;
+    const SymbolTable& symbol_table;
+    TACProgram program;
+    TACFunction* fn;
+    std::vector<int32_t> local_id; // VarId -> variable or array id in fn, -1 if not yet used
+    std::vector<uint32_t> need;    // NodeId -> temporaries an expression needs (Sethi-Ullman number)
+    std::vector<int32_t> free_temps; // temporaries of fn whose value is no longer needed
+    Operand new_temp();
+    void release(const Operand& o);
+    int32_t new_label();
+    Operand var(NodeId id);
+    int32_t array(NodeId id);
+    void begin_function(const std::string& name, bool has_header);
+    void emit(const TACInstr& in) { fn->code.push_back(in); }
+    Operand visit_program(NodeId id);
+    Operand visit_function(NodeId id);
+    Operand visit_decl(NodeId id);
+    Operand visit_assign(NodeId id);
+    Operand visit_binop(NodeId id);
+    Operand visit_relop(NodeId id);
+    Operand visit_number(NodeId id);
+    Operand visit_id(NodeId id);
+    Operand visit_while(NodeId id);
+    Operand visit_if(NodeId id);
+    Operand visit_return(NodeId id);
+    Operand visit_array_decl(NodeId id);
+    Operand visit_index(NodeId id);
+    Operand visit_index_assign(NodeId id);
 };
 
-#endif // TACGENERATOR_H 
\ No newline at end of file
+#endif // TACGENERATOR_H
@@ -1,17 +1,56 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 #include <string>
+#include <string_view>
 
+enum class TokenKind : unsigned char {
+    FOR, WHILE, IF, ELSE, INT, RETURN,
+    NUMBER, ID, ASSIGN, END, COMMA, OP,
+    LPAREN, RPAREN, LBRACE, RBRACE, LBRACKET, RBRACKET,
+    LE, GE, EQ, NE, LT, GT,
+    EOI, // end of input, never produced by the lexer
+    COUNT
+};
+
+inline const char* token_kind_name(TokenKind kind) {
+    static const char* const names[] = {
+        "FOR", "WHILE", "IF", "ELSE", "INT", "RETURN",
+        "NUMBER", "ID", "ASSIGN", "END", "COMMA", "OP",
+        "LPAREN", "RPAREN", "LBRACE", "RBRACE", "LBRACKET", "RBRACKET",
+        "LE", "GE", "EQ", "NE", "LT", "GT",
+        "EOF"
+    };
+    return names[static_cast<int>(kind)];
+}
+
+// Kinds that can begin a statement inside a block: ID WHILE IF FOR INT RETURN.
+inline bool starts_statement(TokenKind kind) {
+    static const bool table[static_cast<int>(TokenKind::COUNT)] = {
+        true, true, true, false, true, true,
+        false, true, false, false, false, false,
+        false, false, false, false, false, false,
+        false, false, false, false, false, false,
+        false
+    };
+    return table[static_cast<int>(kind)];
+}
+
+inline bool is_relop(TokenKind kind) {
+    return kind >= TokenKind::LE && kind <= TokenKind::GT;
+}
+
+// value is a span of the lexer's source buffer, so a Token is only valid
+// while the Lexer that produced it lives.
 class Token {
 public:
-    std::string type;
-    std::string value;
+    TokenKind kind;
     int line;
-    Token(const std::string& type_, const std::string& value_, int line_)
-        : type(type_), value(value_), line(line_) {}
+    std::string_view value;
+    Token(TokenKind kind_, std::string_view value_, int line_)
+        : kind(kind_), line(line_), value(value_) {}
     std::string repr() const {
-        return "Token(" + type + ", " + value + ", line=" + std::to_string(line) + ")";
+        return std::string("Token(") + token_kind_name(kind) + ", " + std::string(value) + ", line=" + std::to_string(line) + ")";
     }
 };
 
-#endif // TOKEN_H 
\ No newline at end of file
+#endif // TOKEN_H
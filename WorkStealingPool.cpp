@@ -0,0 +1,86 @@
+#include "WorkStealingPool.h"
+using namespace std;
+
+WorkStealingPool::WorkStealingPool(size_t threads) {
+    if (threads == 0) threads = 1;
+    for (size_t i = 0; i < threads; ++i) queues.push_back(make_unique<Queue>());
+    for (size_t i = 0; i < threads; ++i) workers.emplace_back(&WorkStealingPool::run, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        lock_guard<mutex> lock(m);
+        stopping = true;
+    }
+    work.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+// The task is in its deque before the counters say so are released, so a
+// worker that sees queued > 0 always finds something to take or steal.
+void WorkStealingPool::submit(function<void()> task) {
+    {
+        lock_guard<mutex> lock(m);
+        Queue& q = *queues[next];
+        next = (next + 1) % queues.size();
+        {
+            lock_guard<mutex> qlock(q.m);
+            q.tasks.push_back(move(task));
+        }
+        ++queued;
+        ++pending;
+    }
+    work.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    unique_lock<mutex> lock(m);
+    idle.wait(lock, [this] { return pending == 0; });
+    if (error) {
+        exception_ptr e = error;
+        error = nullptr;
+        rethrow_exception(e);
+    }
+}
+
+bool WorkStealingPool::take(size_t self, function<void()>& task) {
+    for (size_t k = 0; k < queues.size(); ++k) {
+        Queue& q = *queues[(self + k) % queues.size()];
+        lock_guard<mutex> qlock(q.m);
+        if (q.tasks.empty()) continue;
+        if (k == 0) {
+            task = move(q.tasks.back());
+            q.tasks.pop_back();
+        } else {
+            task = move(q.tasks.front());
+            q.tasks.pop_front();
+        }
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::run(size_t self) {
+    function<void()> task;
+    for (;;) {
+        {
+            unique_lock<mutex> lock(m);
+            work.wait(lock, [this] { return stopping || queued > 0; });
+            if (queued == 0) return; // stopping with nothing left
+        }
+        if (!take(self, task)) continue; // another worker got there first
+        {
+            lock_guard<mutex> lock(m);
+            --queued;
+        }
+        try {
+            task();
+        } catch (...) {
+            lock_guard<mutex> lock(m);
+            if (!error) error = current_exception();
+        }
+        task = nullptr;
+        lock_guard<mutex> lock(m);
+        if (--pending == 0) idle.notify_all();
+    }
+}
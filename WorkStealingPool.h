@@ -0,0 +1,48 @@
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads, each with its own task deque. Tasks are dealt
+// out round-robin; a worker runs its own tasks newest first and, once its
+// deque is empty, steals the oldest task of another worker, so a few slow
+// tasks do not leave the other threads idle.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(size_t threads);
+    ~WorkStealingPool();
+
+    void submit(std::function<void()> task);
+    // Blocks until every submitted task has finished, then rethrows the first
+    // exception a task let escape, if any.
+    void wait();
+    size_t size() const { return workers.size(); }
+
+private:
+    struct Queue {
+        std::mutex m;
+        std::deque<std::function<void()>> tasks;
+    };
+    std::vector<std::unique_ptr<Queue>> queues; // one per worker
+    std::vector<std::thread> workers;
+    std::mutex m;                   // guards the counters below
+    std::condition_variable work;   // signalled when a task is queued or on shutdown
+    std::condition_variable idle;   // signalled when pending drops to zero
+    size_t queued = 0;              // tasks sitting in some deque
+    size_t pending = 0;             // tasks submitted and not yet finished
+    size_t next = 0;                // deque the next task goes to
+    bool stopping = false;
+    std::exception_ptr error;
+
+    bool take(size_t self, std::function<void()>& task);
+    void run(size_t self);
+};
+
+#endif // WORKSTEALINGPOOL_H
@@ -0,0 +1,571 @@
+#include "X86Backend.h"
+#include <algorithm>
+#include <set>
+#include <unordered_set>
+#include <utility>
+#include "CFG.h"
+#include "Dominators.h"
+#include "Liveness.h"
+#include "SSA.h"
+using namespace std;
+
+namespace {
+
+struct Register {
+    const char* r32;
+    const char* r64;
+    bool callee_saved;
+};
+
+// Caller-saved registers come first, so small functions need not save any.
+// %eax, %ecx and %edx stay free as scratch: idiv works in %edx:%eax and a
+// variable shift count has to be in %cl.
+const Register registers[] = {
+    {"%esi", "%rsi", false}, {"%edi", "%rdi", false}, {"%r8d", "%r8", false},
+    {"%r9d", "%r9", false}, {"%r10d", "%r10", false}, {"%r11d", "%r11", false},
+    {"%ebx", "%rbx", true}, {"%r12d", "%r12", true}, {"%r13d", "%r13", true},
+    {"%r14d", "%r14", true}, {"%r15d", "%r15", true},
+};
+const int REGISTER_COUNT = sizeof registers / sizeof registers[0];
+
+const char* jump_unless(TACOp op) {
+    switch (op) {
+        case TACOp::LT: return "jge";
+        case TACOp::GT: return "jle";
+        case TACOp::LE: return "jg";
+        case TACOp::GE: return "jl";
+        case TACOp::EQ: return "jne";
+        default:        return "je";
+    }
+}
+
+const char* set_if(TACOp op) {
+    switch (op) {
+        case TACOp::LT: return "setl";
+        case TACOp::GT: return "setg";
+        case TACOp::LE: return "setle";
+        case TACOp::GE: return "setge";
+        case TACOp::EQ: return "sete";
+        default:        return "setne";
+    }
+}
+
+// Renames every name into its webs: the assignments and reads joined by
+// reaching one another, through phis where control flow merges, become one
+// temporary. The generator reuses a few temporaries all over a function and a
+// variable may be reassigned in unrelated loops; without the split each of
+// those is one interval spanning most of the function, and the allocator
+// spills them first. Code SSA gives no values (unreachable blocks) keeps one
+// web per name.
+TACFunction split_webs(const TACFunction& f) {
+    CFG cfg(f.code);
+    DominatorTree dom(cfg);
+    SSA ssa(f, cfg, dom);
+    vector<ValueId> parent(ssa.values.size());
+    for (ValueId v = 0; v < parent.size(); ++v) parent[v] = v;
+    auto find = [&](ValueId v) {
+        while (parent[v] != v) v = parent[v] = parent[parent[v]];
+        return v;
+    };
+    for (const auto& phi : ssa.phis) {
+        for (ValueId arg : phi.args) {
+            if (arg != SSA::NO_VALUE) parent[find(arg)] = find(phi.value);
+        }
+    }
+
+    // Webs are numbered in order of first appearance, values first and then
+    // the names of unreachable code.
+    size_t names = f.vars.size() + static_cast<size_t>(f.temp_count) + 1;
+    vector<int32_t> web(ssa.values.size() + names, 0);
+    int32_t webs = 0;
+    TACFunction out = f;
+    for (uint32_t i = 0; i < f.code.size(); ++i) {
+        TACInstr& in = out.code[i];
+        const pair<Operand*, ValueId> operands[] = {{&in.dst, ssa.def[i]}, {&in.a, ssa.use_a[i]}, {&in.b, ssa.use_b[i]}};
+        for (const auto& [o, value] : operands) {
+            if (!o->is_name()) continue;
+            size_t n = value != SSA::NO_VALUE ? find(value)
+                                              : ssa.values.size() + (o->kind == Operand::VAR ? o->value : f.vars.size() + o->value);
+            if (!web[n]) web[n] = ++webs;
+            *o = Operand::temp(web[n]);
+        }
+    }
+    out.temp_count = webs;
+    return out;
+}
+
+class FunctionLowering {
+public:
+    FunctionLowering(const TACFunction& f, size_t index, string& out)
+        : f(f), cfg(f.code), liveness(f, cfg), prefix(".L" + to_string(index) + "_"), out(out) {}
+
+    void lower(const string& symbol);
+
+private:
+    const TACFunction& f;
+    CFG cfg;
+    Liveness liveness;
+    string prefix;             // of this function's local labels
+    string& out;
+    vector<uint32_t> start;    // live interval per name index, [start, end] in code positions
+    vector<uint32_t> end;
+    vector<int> reg;           // register per name index, -1 if spilled
+    vector<int> slot;          // stack slot per name index, -1 if in a register
+    vector<char> vector_name;  // per name index: a vector temporary, width slots wide
+    int slots = 0;
+    vector<int> saved;         // callee-saved registers used, in push order
+    int local_labels = 0;
+
+    void intervals();
+    void allocate();
+    string loc(const Operand& o) const;
+    int lane_offset(const Operand& o) const;
+    string lane(const Operand& o, int k) const { return to_string(lane_offset(o) + 4 * k) + "(%rbp)"; }
+    string array(int32_t a) const { return prefix + "a" + to_string(a); }
+    bool in_memory(const Operand& o) const { return o.is_name() && reg[liveness.index(o)] < 0; }
+    void emit(const string& text) { out += "    " + text + "\n"; }
+    void label(const string& name) { out += name + ":\n"; }
+    void mov(const string& src, const string& dst);
+    size_t lower(size_t i); // returns the index of the next instruction to lower
+    void lower_memory(const TACInstr& in);
+    void lower_vector(const TACInstr& in);
+};
+
+// A name's interval runs from its first to its last appearance, stretched
+// over the blocks it is live into or out of. Intervals without holes are
+// conservative, so two names whose intervals do not overlap are never live
+// at the same time.
+void FunctionLowering::intervals() {
+    size_t names = f.vars.size() + static_cast<size_t>(f.temp_count) + 1;
+    start.assign(names, UINT32_MAX);
+    end.assign(names, 0);
+    auto touch = [this](size_t n, uint32_t pos) {
+        start[n] = min(start[n], pos);
+        end[n] = max(end[n], pos);
+    };
+    for (BlockId b = 0; b < cfg.size(); ++b) {
+        const BasicBlock& block = cfg.blocks[b];
+        liveness.live_in[b].for_each([&](size_t s) { touch(liveness.globals[s], block.begin); });
+        liveness.live_out[b].for_each([&](size_t s) { touch(liveness.globals[s], block.end - 1); });
+    }
+    for (uint32_t i = 0; i < f.code.size(); ++i) {
+        const TACInstr& in = f.code[i];
+        for (const Operand* o : {&in.dst, &in.a, &in.b}) {
+            if (o->is_name()) touch(liveness.index(*o), i);
+        }
+    }
+}
+
+// Linear scan: intervals are taken by start; when every register is busy,
+// whichever of the new interval and the active one ending last ends later
+// is spilled to the stack for its whole life. Vector temporaries always live
+// on the stack.
+void FunctionLowering::allocate() {
+    reg.assign(start.size(), -1);
+    slot.assign(start.size(), -1);
+    vector_name.assign(start.size(), 0);
+    for (const auto& in : f.code) {
+        unsigned vectors = vector_operands(in.op);
+        if (vectors & 1) vector_name[liveness.index(in.dst)] = 1;
+        if (vectors & 2) vector_name[liveness.index(in.a)] = 1;
+        if (vectors & 4) vector_name[liveness.index(in.b)] = 1;
+    }
+    vector<size_t> order;
+    for (size_t n = 0; n < start.size(); ++n) {
+        if (vector_name[n]) {
+            slot[n] = slots;
+            slots += f.vector_width;
+        } else if (start[n] != UINT32_MAX) {
+            order.push_back(n);
+        }
+    }
+    sort(order.begin(), order.end(), [this](size_t x, size_t y) { return start[x] != start[y] ? start[x] < start[y] : x < y; });
+
+    set<pair<uint32_t, size_t>> active; // (end, name)
+    bool busy[REGISTER_COUNT] = {};
+    bool used[REGISTER_COUNT] = {};
+    for (size_t n : order) {
+        while (!active.empty() && active.begin()->first < start[n]) {
+            busy[reg[active.begin()->second]] = false;
+            active.erase(active.begin());
+        }
+        int r = 0;
+        while (r < REGISTER_COUNT && busy[r]) ++r;
+        if (r == REGISTER_COUNT) {
+            auto last = prev(active.end());
+            if (last->first <= end[n]) {
+                slot[n] = slots++;
+                continue;
+            }
+            r = reg[last->second];
+            reg[last->second] = -1;
+            slot[last->second] = slots++;
+            active.erase(last);
+        }
+        reg[n] = r;
+        busy[r] = used[r] = true;
+        active.emplace(end[n], n);
+    }
+    for (int r = 0; r < REGISTER_COUNT; ++r) {
+        if (used[r] && registers[r].callee_saved) saved.push_back(r);
+    }
+}
+
+// Spill slots sit below the saved registers in the frame.
+string FunctionLowering::loc(const Operand& o) const {
+    if (o.is_const()) return "$" + to_string(o.value);
+    size_t n = liveness.index(o);
+    if (reg[n] >= 0) return registers[reg[n]].r32;
+    return to_string(-static_cast<int>(8 * saved.size() + 4 * (slot[n] + 1))) + "(%rbp)";
+}
+
+// Of lane 0; the lanes of a vector go up in memory from there.
+int FunctionLowering::lane_offset(const Operand& o) const {
+    return -static_cast<int>(8 * saved.size() + 4 * (slot[liveness.index(o)] + f.vector_width));
+}
+
+void FunctionLowering::mov(const string& src, const string& dst) {
+    if (src == dst) return;
+    if (src.back() == ')' && dst.back() == ')') {
+        emit("movl " + src + ", %eax");
+        emit("movl %eax, " + dst);
+    } else {
+        emit("movl " + src + ", " + dst);
+    }
+}
+
+void FunctionLowering::lower(const string& symbol) {
+    intervals();
+    allocate();
+
+    out += "    .globl " + symbol + "\n    .type " + symbol + ", @function\n" + symbol + ":\n";
+    emit("pushq %rbp");
+    emit("movq %rsp, %rbp");
+    for (int r : saved) emit(string("pushq ") + registers[r].r64);
+    if (slots) emit("subq $" + to_string((4 * slots + 15) / 16 * 16) + ", %rsp");
+    // Arrays, and variables read before they are written, start at 0.
+    for (size_t a = 0; a < f.arrays.size(); ++a) {
+        emit("leaq " + array(static_cast<int32_t>(a)) + "(%rip), %rdi");
+        emit("movl $" + to_string(f.arrays[a].length) + ", %ecx");
+        emit("xorl %eax, %eax");
+        emit("rep stosl");
+    }
+    if (cfg.size() > 0) {
+        liveness.live_in[0].for_each([&](size_t s) {
+            size_t n = liveness.globals[s];
+            Operand o = n < f.vars.size() ? Operand::var(static_cast<int32_t>(n))
+                                          : Operand::temp(static_cast<int32_t>(n - f.vars.size()));
+            if (!vector_name[n]) {
+                emit("movl $0, " + loc(o));
+                return;
+            }
+            for (int k = 0; k < f.vector_width; ++k) emit("movl $0, " + lane(o, k));
+        });
+    }
+
+    for (size_t i = 0; i < f.code.size();) i = lower(i);
+
+    if (f.code.empty() || f.code.back().op != TACOp::RETURN) emit("xorl %eax, %eax"); // ran off the end
+    label(prefix + "ret");
+    if (slots || !saved.empty()) emit("leaq -" + to_string(8 * saved.size()) + "(%rbp), %rsp");
+    for (auto r = saved.rbegin(); r != saved.rend(); ++r) emit(string("popq ") + registers[*r].r64);
+    emit("popq %rbp");
+    emit("ret");
+    out += "    .size " + symbol + ", .-" + symbol + "\n";
+    // Arrays are static, zeroed again on every call.
+    for (size_t a = 0; a < f.arrays.size(); ++a) {
+        string name = array(static_cast<int32_t>(a));
+        out += "    .local " + name + "\n    .comm " + name + ", " + to_string(4 * static_cast<int64_t>(f.arrays[a].length)) + ", 16\n";
+    }
+    out += "\n";
+}
+
+// An index outside the array loads 0 and stores nothing. It is compared
+// unsigned, so a negative index is outside as well.
+void FunctionLowering::lower_memory(const TACInstr& in) {
+    bool load = in.op == TACOp::LOAD;
+    uint32_t length = static_cast<uint32_t>(f.arrays[in.label].length);
+    string value = load ? "" : loc(in.b);
+    if (!load && in_memory(in.b)) {
+        emit("movl " + value + ", %eax");
+        value = "%eax";
+    }
+    if (in.a.is_const()) {
+        uint32_t index = static_cast<uint32_t>(in.a.value);
+        string element = array(in.label) + "+" + to_string(4 * static_cast<uint64_t>(index)) + "(%rip)";
+        if (load) mov(index < length ? element : "$0", loc(in.dst));
+        else if (index < length) emit("movl " + value + ", " + element);
+        return;
+    }
+    string skip = prefix + "index" + to_string(local_labels++);
+    emit("movl " + loc(in.a) + ", %ecx");
+    if (load) emit("xorl %eax, %eax");
+    emit("cmpl $" + to_string(length) + ", %ecx");
+    emit("jae " + skip);
+    emit("leaq " + array(in.label) + "(%rip), %rdx");
+    emit(load ? "movl (%rdx,%rcx,4), %eax" : "movl " + value + ", (%rdx,%rcx,4)");
+    label(skip);
+    if (load) mov("%eax", loc(in.dst));
+}
+
+// Vectors go through SSE2 four lanes at a time; lanes past the last multiple
+// of four are handled one by one in %eax.
+void FunctionLowering::lower_vector(const TACInstr& in) {
+    const int width = f.vector_width;
+    const int packed = width / 4 * 4;
+    switch (in.op) {
+        case TACOp::VLOAD:
+        case TACOp::VSTORE: {
+            bool load = in.op == TACOp::VLOAD;
+            const Operand& v = load ? in.dst : in.b;
+            uint32_t length = static_cast<uint32_t>(f.arrays[in.label].length);
+            string l = prefix + "vector" + to_string(local_labels++);
+            emit("movl " + loc(in.a) + ", %ecx");
+            emit("leaq " + array(in.label) + "(%rip), %rdx");
+            if (length >= static_cast<uint32_t>(width)) {
+                // Every lane in range: no checks.
+                emit("cmpl $" + to_string(length - width) + ", %ecx");
+                emit("ja " + l + "_lanes");
+                for (int k = 0; k < width; k += k < packed ? 4 : 1) {
+                    string element = to_string(4 * k) + "(%rdx,%rcx,4)";
+                    string src = load ? element : lane(v, k), dst = load ? lane(v, k) : element;
+                    string scratch = k < packed ? "%xmm0" : "%eax";
+                    emit((k < packed ? "movdqu " : "movl ") + src + ", " + scratch);
+                    emit((k < packed ? "movdqu " : "movl ") + scratch + ", " + dst);
+                }
+                emit("jmp " + l + "_done");
+            }
+            // Lane by lane, %eax counting lanes and %ecx the index.
+            string lanes = to_string(lane_offset(v)) + "(%rbp,%rax,4)";
+            label(l + "_lanes");
+            emit("xorl %eax, %eax");
+            label(l + "_lane");
+            if (load) emit("pxor %xmm0, %xmm0");
+            emit("cmpl $" + to_string(length) + ", %ecx");
+            emit("jae " + l + "_next");
+            emit("movd " + (load ? "(%rdx,%rcx,4)" : lanes) + ", %xmm0");
+            if (!load) emit("movd %xmm0, (%rdx,%rcx,4)");
+            label(l + "_next");
+            if (load) emit("movd %xmm0, " + lanes);
+            emit("incl %ecx");
+            emit("incl %eax");
+            emit("cmpl $" + to_string(width) + ", %eax");
+            emit("jl " + l + "_lane");
+            label(l + "_done");
+            return;
+        }
+        case TACOp::VADD:
+        case TACOp::VSUB:
+        case TACOp::VMUL:
+            for (int k = 0; k < packed; k += 4) {
+                emit("movdqu " + lane(in.a, k) + ", %xmm0");
+                emit("movdqu " + lane(in.b, k) + ", %xmm1");
+                if (in.op == TACOp::VMUL) {
+                    // SSE2 has no 32-bit pmulld: even and odd lanes multiply
+                    // separately into 64 bits and the low halves are merged.
+                    emit("movdqa %xmm0, %xmm2");
+                    emit("pmuludq %xmm1, %xmm0");
+                    emit("psrlq $32, %xmm2");
+                    emit("psrlq $32, %xmm1");
+                    emit("pmuludq %xmm1, %xmm2");
+                    emit("pshufd $8, %xmm0, %xmm0");
+                    emit("pshufd $8, %xmm2, %xmm2");
+                    emit("punpckldq %xmm2, %xmm0");
+                } else {
+                    emit(string(in.op == TACOp::VADD ? "paddd" : "psubd") + " %xmm1, %xmm0");
+                }
+                emit("movdqu %xmm0, " + lane(in.dst, k));
+            }
+            for (int k = packed; k < width; ++k) {
+                const char* op = in.op == TACOp::VADD ? "addl " : in.op == TACOp::VSUB ? "subl " : "imull ";
+                emit("movl " + lane(in.a, k) + ", %eax");
+                emit(op + lane(in.b, k) + ", %eax");
+                emit("movl %eax, " + lane(in.dst, k));
+            }
+            return;
+        case TACOp::VSPLAT:
+            emit("movl " + loc(in.a) + ", %eax");
+            if (packed) {
+                emit("movd %eax, %xmm0");
+                emit("pshufd $0, %xmm0, %xmm0");
+            }
+            for (int k = 0; k < packed; k += 4) emit("movdqu %xmm0, " + lane(in.dst, k));
+            for (int k = packed; k < width; ++k) emit("movl %eax, " + lane(in.dst, k));
+            return;
+        default: // VSUM
+            if (packed) {
+                emit("movdqu " + lane(in.a, 0) + ", %xmm0");
+                for (int k = 4; k < packed; k += 4) {
+                    emit("movdqu " + lane(in.a, k) + ", %xmm1");
+                    emit("paddd %xmm1, %xmm0");
+                }
+                emit("pshufd $0x4e, %xmm0, %xmm1");
+                emit("paddd %xmm1, %xmm0");
+                emit("pshufd $0xb1, %xmm0, %xmm1");
+                emit("paddd %xmm1, %xmm0");
+                emit("movd %xmm0, %eax");
+            } else {
+                emit("xorl %eax, %eax");
+            }
+            for (int k = packed; k < width; ++k) emit("addl " + lane(in.a, k) + ", %eax");
+            mov("%eax", loc(in.dst));
+            return;
+    }
+}
+
+size_t FunctionLowering::lower(size_t i) {
+    const TACInstr& in = f.code[i];
+    string target = prefix + to_string(in.label);
+    switch (in.op) {
+        case TACOp::LABEL:
+            label(target);
+            return i + 1;
+        case TACOp::GOTO:
+            emit("jmp " + target);
+            return i + 1;
+        case TACOp::IF_FALSE:
+            if (in.a.is_const()) {
+                if (in.a.value == 0) emit("jmp " + target);
+            } else {
+                emit("cmpl $0, " + loc(in.a));
+                emit("je " + target);
+            }
+            return i + 1;
+        case TACOp::RETURN:
+            mov(loc(in.a), "%eax");
+            if (i + 1 < f.code.size()) emit("jmp " + prefix + "ret");
+            return i + 1;
+        case TACOp::COPY:
+            mov(loc(in.a), loc(in.dst));
+            return i + 1;
+        case TACOp::LOAD:
+        case TACOp::STORE:
+            lower_memory(in);
+            return i + 1;
+        default:
+            if (is_vector(in.op)) {
+                lower_vector(in);
+                return i + 1;
+            }
+            break;
+    }
+
+    string d = loc(in.dst), a = loc(in.a), b = loc(in.b);
+    if (is_relational(in.op)) {
+        // A comparison only feeding the ifFalse after it becomes a compare
+        // and a conditional jump; the 0/1 value is never materialized.
+        size_t t = liveness.index(in.dst);
+        bool fused = i + 1 < f.code.size() && f.code[i + 1].op == TACOp::IF_FALSE && f.code[i + 1].a == in.dst
+                     && start[t] == i && end[t] == i + 1;
+        if (in.a.is_const() || (in.a.is_name() && in.b.is_name() && in_memory(in.a) && in_memory(in.b))) {
+            emit("movl " + a + ", %eax");
+            a = "%eax";
+        }
+        emit("cmpl " + b + ", " + a);
+        if (fused) {
+            emit(string(jump_unless(in.op)) + " " + prefix + to_string(f.code[i + 1].label));
+            return i + 2;
+        }
+        emit(string(set_if(in.op)) + " %al");
+        emit("movzbl %al, %eax");
+        mov("%eax", d);
+        return i + 1;
+    }
+
+    switch (in.op) {
+        case TACOp::ADD:
+        case TACOp::SUB:
+        case TACOp::MUL: {
+            const char* op = in.op == TACOp::ADD ? "addl " : in.op == TACOp::SUB ? "subl " : "imull ";
+            if (d == b && d != a && in.op != TACOp::SUB) swap(a, b);
+            if (!in_memory(in.dst) && d != b) {
+                mov(a, d);
+                emit(op + b + ", " + d);
+            } else {
+                emit("movl " + a + ", %eax");
+                emit(op + b + ", %eax");
+                mov("%eax", d);
+            }
+            return i + 1;
+        }
+        case TACOp::DIV:
+            // x / 0 is 0 and x / -1 wraps like negation, as in fold_binary.
+            emit("movl " + a + ", %eax");
+            if (in.b.is_const()) {
+                if (in.b.value == 0) {
+                    emit("xorl %eax, %eax");
+                } else if (in.b.value == -1) {
+                    emit("negl %eax");
+                } else {
+                    emit("movl " + b + ", %ecx");
+                    emit("cltd");
+                    emit("idivl %ecx");
+                }
+            } else {
+                string l = prefix + "div" + to_string(local_labels++);
+                emit("movl " + b + ", %ecx");
+                emit("testl %ecx, %ecx");
+                emit("jne " + l + "_nonzero");
+                emit("xorl %eax, %eax");
+                emit("jmp " + l + "_done");
+                label(l + "_nonzero");
+                emit("cmpl $-1, %ecx");
+                emit("jne " + l + "_divide");
+                emit("negl %eax");
+                emit("jmp " + l + "_done");
+                label(l + "_divide");
+                emit("cltd");
+                emit("idivl %ecx");
+                label(l + "_done");
+            }
+            mov("%eax", d);
+            return i + 1;
+        default: { // SHL, SHR: the count is taken mod 32, as the hardware does
+            const char* op = in.op == TACOp::SHL ? "sall " : "sarl ";
+            emit("movl " + a + ", %eax");
+            if (in.b.is_const()) {
+                emit(op + ("$" + to_string(in.b.value & 31)) + ", %eax");
+            } else {
+                emit("movl " + b + ", %ecx");
+                emit(op + string("%cl, %eax"));
+            }
+            mov("%eax", d);
+            return i + 1;
+        }
+    }
+}
+
+} // namespace
+
+string x86_64_assembly(const TACProgram& program) {
+    string out = "# x86-64 code generated from optimized TAC\n    .text\n\n";
+    vector<string> symbols;
+    unordered_set<string> taken;
+    size_t entry = program.functions.size() - 1;
+    for (size_t i = 0; i < program.functions.size(); ++i) {
+        const TACFunction& f = program.functions[i];
+        string symbol = "cd_" + (f.has_header ? f.name : string("program"));
+        if (!taken.insert(symbol).second) symbol += "_" + to_string(i);
+        symbols.push_back(symbol);
+        if (f.has_header && f.name == "main") entry = i;
+        TACFunction webs = split_webs(f);
+        FunctionLowering(webs, i, out).lower(symbol);
+    }
+    if (program.functions.empty()) return out;
+
+    // main(argc, argv): runs the entry function argv[1] times (once without
+    // an argument) and prints what it returned.
+    out += "    .section .rodata\n.Lformat:\n    .string \"%d\\n\"\n    .text\n"
+           "    .globl main\n    .type main, @function\nmain:\n"
+           "    pushq %rbp\n    movq %rsp, %rbp\n    pushq %rbx\n    pushq %r12\n"
+           "    movl $1, %ebx\n    cmpl $2, %edi\n    jl .Lrun\n"
+           "    movq 8(%rsi), %rdi\n    call atoi@PLT\n    movl %eax, %ebx\n"
+           ".Lrun:\n    xorl %r12d, %r12d\n"
+           ".Lrepeat:\n    testl %ebx, %ebx\n    jle .Lprint\n"
+           "    call " + symbols[entry] + "\n    movl %eax, %r12d\n    decl %ebx\n    jmp .Lrepeat\n"
+           ".Lprint:\n    movl %r12d, %esi\n    leaq .Lformat(%rip), %rdi\n    xorl %eax, %eax\n    call printf@PLT\n"
+           "    xorl %eax, %eax\n    popq %r12\n    popq %rbx\n    popq %rbp\n    ret\n"
+           "    .size main, .-main\n"
+           "    .section .note.GNU-stack,\"\",@progbits\n";
+    return out;
+}
@@ -0,0 +1,18 @@
+#ifndef X86BACKEND_H
+#define X86BACKEND_H
+#include <string>
+#include "TAC.h"
+
+// Lowers TAC to x86-64 assembly for the GNU assembler (AT&T syntax, System V
+// ABI). Each function becomes cd_<name> (cd_program for a top-level statement
+// list), returning its value in %eax; variables and temporaries are split into
+// webs of the assignments and reads that reach each other, placed in registers
+// by linear-scan allocation over their live intervals and spilled to the stack
+// frame when registers run out. Arrays are static storage zeroed on entry, and
+// vector operations use SSE2, four lanes to an instruction. A C main calls the
+// entry function (main, else the last function) as many times as its first
+// argument says, default once, and prints the result, so the output links with
+//   cc output.s -o program
+std::string x86_64_assembly(const TACProgram& program);
+
+#endif // X86BACKEND_H
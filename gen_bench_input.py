@@ -0,0 +1,67 @@
+import argparse
+import random
+
+# Generates large, valid input programs for timing the compiler stages.
+# Usage: python3 gen_bench_input.py --lines 20000 > big_input.txt
+#        python3 gen_bench_input.py --functions 64 --lines 2000 > many_functions.txt
+#        python3 gen_bench_input.py --lines 2000 --depth 8 > big_expressions.txt
+
+def gen_expr(rng, names, max_depth, depth=0):
+    if depth > max_depth or rng.random() < 0.4:
+        if rng.random() < 0.5:
+            return rng.choice(names)
+        return str(rng.randint(0, 99))
+    op = rng.choice(["+", "-", "*", "/"])
+    return gen_expr(rng, names, max_depth, depth + 1) + " " + op + " " + gen_expr(rng, names, max_depth, depth + 1)
+
+def gen_function(rng, name, lines, depth):
+    out = ["int " + name + "() {"]
+    names = []
+    for k in range(8):
+        v = "v" + str(k)
+        names.append(v)
+        out.append("    int " + v + " = " + str(rng.randint(0, 9)) + ";")
+    emitted = len(out)
+    loop = 0
+    while emitted < lines:
+        kind = rng.random()
+        if kind < 0.15:
+            i = "i" + str(loop)
+            loop += 1
+            out.append("    int " + i + " = 0;")
+            out.append("    while (" + i + " < " + str(rng.randint(2, 20)) + ") {")
+            for _ in range(rng.randint(2, 5)):
+                out.append("        " + rng.choice(names) + " = " + gen_expr(rng, names + [i], depth) + ";")
+            out.append("        " + i + " = " + i + " + 1;")
+            out.append("    }")
+            emitted += 6
+        elif kind < 0.25:
+            out.append("    if (" + rng.choice(names) + " < " + gen_expr(rng, names, depth) + ") {")
+            out.append("        " + rng.choice(names) + " = " + gen_expr(rng, names, depth) + ";")
+            out.append("    } else {")
+            out.append("        " + rng.choice(names) + " = " + gen_expr(rng, names, depth) + ";")
+            out.append("    }")
+            emitted += 5
+        else:
+            out.append("    " + rng.choice(names) + " = " + gen_expr(rng, names, depth) + "; // generated")
+            emitted += 1
+    out.append("    return " + " + ".join(names) + ";")
+    out.append("}")
+    return out
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--lines", type=int, default=10000, help="approximate lines in each generated function")
+    ap.add_argument("--functions", type=int, default=1, help="number of functions; the last one is main")
+    ap.add_argument("--depth", type=int, default=2, help="how deep generated expressions may nest")
+    ap.add_argument("--seed", type=int, default=1)
+    args = ap.parse_args()
+    rng = random.Random(args.seed)
+    out = []
+    for k in range(args.functions - 1):
+        out += gen_function(rng, "f" + str(k), args.lines, args.depth)
+    out += gen_function(rng, "main", args.lines, args.depth)
+    print("\n".join(out))
+
+if __name__ == "__main__":
+    main()
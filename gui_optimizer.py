@@ -3,9 +3,44 @@ from tkinter import scrolledtext, messagebox
 import subprocess
 import os
 
+class CompileServer:
+    """One long-lived `compiler --serve` process that compiles source text sent over its stdin."""
+    def __init__(self):
+        self.exe = "compiler.exe" if os.name == "nt" else "./compiler"
+        self.proc = None
+
+    def compile(self, code):
+        # Returns {output file name: contents}; raises RuntimeError on a compile error.
+        if self.proc is None or self.proc.poll() is not None:
+            # Unchanged functions are served from the on-disk cache between compiles,
+            # and only the two listings shown are produced.
+            self.proc = subprocess.Popen([self.exe, "--serve", "--emit=tac,opt", "--cache-dir=.compiler_cache"],
+                                         stdin=subprocess.PIPE, stdout=subprocess.PIPE)
+        data = code.encode("utf-8")
+        self.proc.stdin.write(b"compile %d\n" % len(data) + data)
+        self.proc.stdin.flush()
+        head = self.proc.stdout.readline().decode().split()
+        if not head:
+            self.proc = None
+            raise RuntimeError("compiler server exited")
+        if head[0] == "error":
+            raise RuntimeError(self.proc.stdout.read(int(head[1])).decode("utf-8", "replace"))
+        outputs = {}
+        for _ in range(int(head[1])):
+            name, size = self.proc.stdout.readline().decode().split()
+            outputs[name] = self.proc.stdout.read(int(size)).decode("utf-8", "replace")
+        return outputs
+
+    def close(self):
+        if self.proc is not None and self.proc.poll() is None:
+            self.proc.stdin.write(b"quit\n")
+            self.proc.stdin.close()
+            self.proc.wait()
+
 class OptimizerGUI:
     def __init__(self, root):
         self.root = root
+        self.server = CompileServer()
         self.root.title("C++ Code Optimizer GUI")
         self.root.geometry("1350x600")
 
@@ -47,37 +82,22 @@ class OptimizerGUI:
         if not code:
             messagebox.showwarning("No Input", "Please enter some code to optimize.")
             return
-        # Write input to file
-        with open("input_code.txt", "w", encoding="utf-8") as f:
-            f.write(code)
-        # Run the C++ optimizer
-        exe = "compiler.exe" if os.name == "nt" else "./compiler"
         try:
-            result = subprocess.run([exe, "input_code.txt"], capture_output=True, text=True, timeout=10)
-            if result.returncode != 0:
-                messagebox.showerror("Error", f"Optimizer failed:\n{result.stderr}")
-                return
+            outputs = self.server.compile(code)
         except Exception as e:
-            messagebox.showerror("Error", f"Failed to run optimizer: {e}")
+            messagebox.showerror("Error", f"Optimizer failed:\n{e}")
             return
-        # Read and display TAC
-        try:
-            with open("tac.txt", "r", encoding="utf-8") as f:
-                tac = f.read()
-        except:
-            tac = "[Could not read tac.txt]"
         self.tac_text.delete("1.0", tk.END)
-        self.tac_text.insert(tk.END, tac)
-        # Read and display optimized code
-        try:
-            with open("optimized_output.txt", "r", encoding="utf-8") as f:
-                opt = f.read()
-        except:
-            opt = "[Could not read optimized_output.txt]"
+        self.tac_text.insert(tk.END, outputs.get("tac.txt", "[No TAC produced]"))
         self.optimized_text.delete("1.0", tk.END)
-        self.optimized_text.insert(tk.END, opt)
+        self.optimized_text.insert(tk.END, outputs.get("optimized_output.txt", "[No optimized code produced]"))
+
+    def close(self):
+        self.server.close()
+        self.root.destroy()
 
 if __name__ == "__main__":
     root = tk.Tk()
     app = OptimizerGUI(root)
+    root.protocol("WM_DELETE_WINDOW", app.close)
     root.mainloop() 
\ No newline at end of file
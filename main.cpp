@@ -2,56 +2,536 @@
 #include <fstream>
 #include <vector>
 #include <string>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include "BinaryFormat.h"
+#include "CompileCache.h"
+#include "Executor.h"
 #include "Lexer.h"
 #include "Parser.h"
 #include "SemanticAnalyzer.h"
 #include "TACGenerator.h"
 #include "Optimizer.h"
+#include "MemoryStats.h"
+#include "OutputWriter.h"
+#include "WorkStealingPool.h"
+#include "X86Backend.h"
 #include "utils.h"
 using namespace std;
 
+static bool stats = false;
+
+// Wall time and heap allocations of one pipeline stage, printed with --stats.
+struct StageTimer {
+    chrono::steady_clock::time_point start;
+    size_t allocs;
+    StageTimer() { restart(); }
+    void restart() {
+        start = chrono::steady_clock::now();
+        allocs = allocation_count();
+    }
+    double ms() const { return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count(); }
+    void report(const string& stage, size_t items, const string& unit) const {
+        if (!stats) return;
+        double elapsed = ms();
+        cout << "[STATS] " << stage << ": " << items << " " << unit << " in " << elapsed << " ms ("
+             << (elapsed > 0 ? items / (elapsed / 1000.0) : 0) << " " << unit << "/sec), "
+             << allocation_count() - allocs << " allocations" << endl;
+    }
+};
+
+// The outputs --emit can select; emit holds one bit per artifact.
+enum Artifact { TOKENS, AST_TREE, SYMBOLS, TAC_CODE, OPTIMIZED, ASSEMBLY, ARTIFACT_COUNT };
+static const struct {
+    const char* name; // as given to --emit
+    const char* file;
+} artifacts[ARTIFACT_COUNT] = {
+    {"tokens", "tokens.txt"}, {"ast", "parse_tree.txt"}, {"symbols", "symbol_table.txt"},
+    {"tac", "tac.txt"}, {"opt", "optimized_output.txt"}, {"asm", "output.s"},
+};
+static unsigned emit = (1u << ARTIFACT_COUNT) - 1;
+static bool emitted(Artifact a) { return emit & (1u << a); }
+static bool background_writes = false;
+static bool print_listings = false; // --print: also show the TAC listings on stdout
+
+// Where the pipeline starts: --from=ast or --from=tac read inputs saved with
+// --save-ast (ast.bin) or --save-tac (tac.bin, before optimization) instead of
+// source, skipping the stages that produced them.
+enum Start { FROM_SOURCE, FROM_AST, FROM_TAC };
+static Start start = FROM_SOURCE;
+static bool save_ast_image = false;
+static bool save_tac_image = false;
+static bool run_code = false;
+static uint64_t run_limit = 100000000; // --run-limit: instructions a function may run before it is stopped
+static unique_ptr<CompileCache> cache; // --cache-dir; only source inputs have the tokens it keys on
+
+// One input's trip through the pipeline. A batch compiles quietly into a
+// directory per input and keeps the stage times for its report; the server
+// compiles source text it was sent and keeps the outputs in memory.
+struct Compilation {
+    string input;
+    string out_dir;                         // empty for the working directory
+    bool verbose = true;                    // print listings and --stats lines
+    bool in_memory = false;                 // compile source and fill outputs instead of using files
+    string source;
+    vector<pair<string, string>> outputs;   // output file name -> contents
+    vector<pair<string, double>> stage_ms;
+    string error;
+};
+
+// --run: executes every function before and after optimization and reports
+// what each returned and how many instructions it took, so optimization
+// levels can be compared by the work they save. A function still running
+// after run_limit instructions is stopped.
+static void run_functions(const TACProgram& tac, const TACProgram& optimized) {
+    for (size_t i = 0; i < tac.functions.size(); ++i) {
+        string name = tac.functions[i].has_header ? tac.functions[i].name : "(top level)";
+        Executor::Result before = Executor(tac.functions[i]).run(run_limit);
+        Executor::Result after = Executor(optimized.functions[i]).run(run_limit);
+        for (const auto* r : {&before, &after}) {
+            cout << "[RUN] " << name << ": " << (r == &before ? "tac" : "optimized") << " ";
+            if (!r->finished) {
+                cout << "did not finish within " << run_limit << " instructions" << endl;
+                continue;
+            }
+            if (r->returned) cout << "returned " << r->value;
+            else cout << "ran off its end";
+            cout << " after " << r->steps << " instructions in " << r->ns / 1e6 << " ms ("
+                 << (r->steps ? r->ns / r->steps : 0) << " ns/instruction)";
+            if (r == &after && before.finished && after.steps) cout << ", " << static_cast<double>(before.steps) / after.steps << "x fewer";
+            cout << endl;
+        }
+        if (before.finished && after.finished && (before.returned != after.returned || before.value != after.value)) {
+            cout << "[RUN] " << name << ": optimized code does not return the same value" << endl;
+        }
+    }
+}
+
+// Only the outputs selected with --emit are formatted at all. With background
+// writes, files are written while the following stages run.
+static void compile(Compilation& c, const OptimizerOptions& options) {
+    OutputWriter writer(background_writes && !c.in_memory);
+    auto output = [&](Artifact a, string contents) {
+        const char* file = artifacts[a].file;
+        if (c.in_memory) c.outputs.emplace_back(file, move(contents));
+        else writer.write(c.out_dir.empty() ? string(file) : c.out_dir + "/" + file, move(contents));
+    };
+    auto finish = [&c](const StageTimer& timer, const char* stage, size_t items, const char* unit) {
+        c.stage_ms.emplace_back(stage, timer.ms());
+        if (c.verbose) timer.report(stage, items, unit);
+    };
+    auto image_path = [&c](const char* file) { return c.out_dir.empty() ? string(file) : c.out_dir + "/" + file; };
+
+    StageTimer timer;
+    TACProgram tac_program;
+    TACProgram optimized_program;
+    vector<uint64_t> keys;  // cache key per function, when the cache is in use
+    vector<size_t> fresh;   // functions that were not in the cache
+    if (start == FROM_TAC) {
+        tac_program = load_tac(c.input);
+        finish(timer, "load tac", tac_program.functions.size(), "functions");
+    } else {
+        AST ast;
+        if (start == FROM_AST) {
+            load_ast(c.input, ast);
+            finish(timer, "load ast", ast.node_count(), "nodes");
+        } else {
+            // Lexical Analysis
+            unique_ptr<Lexer> lexer = c.in_memory ? make_unique<Lexer>(SourceBuffer::Text{move(c.source)}) : make_unique<Lexer>(c.input);
+            const vector<Token>& tokens = lexer->tokenize();
+            finish(timer, "lex", tokens.size(), "tokens");
+            if (emitted(TOKENS)) {
+                string text;
+                for (const auto& t : tokens) {
+                    text += t.repr();
+                    text += '\n';
+                }
+                output(TOKENS, move(text));
+            }
+
+            // Syntax Analysis
+            timer.restart();
+            Parser parser(tokens, ast);
+            parser.parse();
+            finish(timer, "parse", tokens.size(), "tokens");
+            if (save_ast_image && !c.in_memory) save_ast(ast, image_path("ast.bin"));
+
+            if (cache) {
+                timer.restart();
+                const Token* first = tokens.data();
+                for (const auto& span : parser.function_spans()) keys.push_back(cache->key(first + span.first, first + span.last));
+                if (keys.empty()) keys.push_back(cache->key(first, first + tokens.size()));
+                finish(timer, "cache keys", keys.size(), "functions");
+            }
+        }
+        if (emitted(AST_TREE)) output(AST_TREE, ast.repr());
+
+        // Semantic Analysis
+        timer.restart();
+        SemanticAnalyzer semantic_analyzer(ast);
+        SymbolTable symbol_table = semantic_analyzer.analyze();
+        finish(timer, "semantic", ast.node_count(), "nodes");
+        if (emitted(SYMBOLS)) output(SYMBOLS, symbol_table.repr());
+
+        // Intermediate Code Generation
+        timer.restart();
+        TACGenerator tac_generator(ast, symbol_table);
+        if (keys.empty()) {
+            tac_program = tac_generator.generate();
+        } else {
+            // One unit per function, or the whole file for a top-level statement list.
+            vector<NodeId> units;
+            AST::ChildRange children = ast.children(ast.root);
+            if (ast.node(ast.root).kind == NodeKind::PROGRAM && !children.empty() && ast.node(children[0]).kind == NodeKind::FUNCTION) {
+                units.assign(children.begin(), children.end());
+            } else {
+                units.push_back(ast.root);
+            }
+            tac_program.functions.resize(units.size());
+            optimized_program.functions.resize(units.size());
+            for (size_t i = 0; i < units.size(); ++i) {
+                if (cache->load(keys[i], tac_program.functions[i], optimized_program.functions[i])) continue;
+                tac_program.functions[i] = tac_generator.generate_function(units[i]);
+                fresh.push_back(i);
+            }
+            if (stats && c.verbose) {
+                cout << "[STATS] cache: " << units.size() - fresh.size() << " of " << units.size()
+                     << " functions reused" << endl;
+            }
+        }
+        finish(timer, "tac", ast.node_count(), "nodes");
+        if (stats && c.verbose) {
+            cout << "[STATS] ast: " << ast.node_count() << " nodes, " << ast.memory_bytes() / 1024
+                 << " KB, freed after TAC generation" << endl;
+        }
+        ast.clear();
+        if (save_tac_image && !c.in_memory) save_tac(tac_program, image_path("tac.bin"));
+    }
+    if (stats && c.verbose) {
+        size_t temps = 0;
+        int32_t widest = 0;
+        for (const auto& f : tac_program.functions) {
+            temps += f.temp_count;
+            widest = max(widest, f.temp_count);
+        }
+        cout << "[STATS] temporaries: " << temps << " in " << tac_program.functions.size()
+             << " functions, at most " << widest << " in one" << endl;
+    }
+    bool print = print_listings && c.verbose;
+    if (emitted(TAC_CODE) || print) {
+        string tac = join_lines(tac_lines(tac_program));
+        if (print) cout << "TAC generated:\n" << tac;
+        if (emitted(TAC_CODE)) output(TAC_CODE, move(tac));
+    }
+
+    // Code Optimization; with the cache, only of the functions it did not have.
+    timer.restart();
+    TACProgram missed;
+    for (size_t i : fresh) missed.functions.push_back(tac_program.functions[i]);
+    const TACProgram& input = keys.empty() ? tac_program : missed;
+    Optimizer optimizer(input, options);
+    TACProgram result = optimizer.optimize();
+    size_t instructions = 0;
+    for (const auto& f : input.functions) instructions += f.code.size();
+    finish(timer, "optimize", instructions, "instructions");
+    if (keys.empty()) {
+        optimized_program = move(result);
+    } else {
+        timer.restart();
+        for (size_t k = 0; k < fresh.size(); ++k) {
+            size_t i = fresh[k];
+            optimized_program.functions[i] = move(result.functions[k]);
+            cache->store(keys[i], tac_program.functions[i], optimized_program.functions[i]);
+        }
+        finish(timer, "cache store", fresh.size(), "functions");
+    }
+    if (stats && c.verbose) {
+        cout << "[STATS] optimizer: " << input.functions.size() << " functions on "
+             << min<size_t>(options.jobs, input.functions.size()) << " threads" << endl;
+        for (const auto& p : optimizer.stats()) {
+            cout << "[STATS]   " << p.name << ": " << p.runs << " runs, " << p.changes << " changed, " << p.ms << " ms";
+            if (p.eliminated) cout << ", " << p.eliminated << " instructions eliminated";
+            if (p.blocks_skipped) cout << ", " << p.blocks_skipped << " unchanged blocks skipped";
+            cout << endl;
+        }
+    }
+    if (emitted(OPTIMIZED) || print) {
+        string optimized = join_lines(tac_lines(optimized_program));
+        if (print) cout << "Optimized code:\n" << optimized << flush;
+        if (emitted(OPTIMIZED)) output(OPTIMIZED, move(optimized));
+    }
+
+    // Code Generation
+    if (emitted(ASSEMBLY)) {
+        timer.restart();
+        string assembly = x86_64_assembly(optimized_program);
+        size_t lowered = 0;
+        for (const auto& f : optimized_program.functions) lowered += f.code.size();
+        finish(timer, "backend", lowered, "instructions");
+        output(ASSEMBLY, move(assembly));
+    }
+    if (run_code && c.verbose) run_functions(tac_program, optimized_program);
+
+    timer.restart();
+    vector<string> failed = writer.finish();
+    if (background_writes && !c.in_memory) {
+        c.stage_ms.emplace_back("write wait", timer.ms());
+        if (stats && c.verbose) cout << "[STATS] write: waited " << timer.ms() << " ms for background writes" << endl;
+    }
+    if (!failed.empty()) throw runtime_error("Cannot write " + failed[0]);
+}
+
+// Compiles every input on a work-stealing pool of jobs threads, each into its
+// own out_dir/<file name> directory, then reports the stage times per file in
+// input order and the wall time of the whole batch.
+static int run_batch(const vector<string>& inputs, const string& out_dir, OptimizerOptions options) {
+    size_t threads = min<size_t>(options.jobs, inputs.size());
+    options.jobs = 1; // the files are the unit of parallelism
+    vector<Compilation> batch(inputs.size());
+    // Same-named inputs get _2, _3, ..., skipping names another input already
+    // has: x.txt twice and then x_2.txt go to x, x_2 and x_2_2.
+    map<string, int> seen;  // stem -> last suffix used
+    set<string> taken;      // directory names handed out
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        string stem = filesystem::path(inputs[i]).stem().string();
+        string name = stem;
+        int& n = seen[stem];
+        while (!taken.insert(name).second) name = stem + "_" + to_string(n = max(n, 1) + 1);
+        batch[i].input = inputs[i];
+        batch[i].out_dir = out_dir + "/" + name;
+        batch[i].verbose = false;
+    }
+
+    auto start = chrono::steady_clock::now();
+    {
+        WorkStealingPool pool(threads);
+        for (auto& c : batch) {
+            pool.submit([&c, &options] {
+                try {
+                    filesystem::create_directories(c.out_dir);
+                    compile(c, options);
+                } catch (const exception& e) {
+                    c.error = e.what();
+                }
+            });
+        }
+        pool.wait();
+    }
+    double wall = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    int failed = 0;
+    for (const auto& c : batch) {
+        cout << "[BATCH] " << c.input << " -> " << c.out_dir;
+        if (!c.error.empty()) {
+            ++failed;
+            cout << ": error: " << c.error << endl;
+            continue;
+        }
+        double total = 0;
+        for (size_t i = 0; i < c.stage_ms.size(); ++i) {
+            cout << (i == 0 ? ": " : ", ") << c.stage_ms[i].first << " " << c.stage_ms[i].second << " ms";
+            total += c.stage_ms[i].second;
+        }
+        cout << ", total " << total << " ms" << endl;
+    }
+    cout << "[BATCH] " << batch.size() << " files, " << failed << " failed, in " << wall << " ms on "
+         << threads << " threads" << endl;
+    if (stats) cout << "[STATS] peak RSS: " << peak_rss_kb() << " KB" << endl;
+    return failed ? 1 : 0;
+}
+
+// Answers compile requests on stdin until end of input or a "quit" line:
+//   request:  compile <n>\n followed by n bytes of source
+//   response: ok <k>\n followed by k outputs, each <file name> <n>\n and n bytes
+//         or  error <n>\n followed by n bytes of message
+// An editor keeps one server running instead of starting a process, writing
+// the source to disk and reading five files back for every compile. n is
+// plain decimal digits and at most MAX_REQUEST_BYTES; the source is read as it
+// arrives, so memory follows what the client actually sent.
+const size_t MAX_REQUEST_BYTES = 64 << 20;
+
+static int serve(const OptimizerOptions& options) {
+    string header;
+    while (getline(cin, header)) {
+        if (!header.empty() && header.back() == '\r') header.pop_back();
+        if (header.empty()) continue;
+        if (header == "quit") break;
+        Compilation c;
+        c.input = "<request>";
+        c.verbose = false;
+        c.in_memory = true;
+        try {
+            if (header.compare(0, 8, "compile ") != 0) throw runtime_error("Unknown request: " + header);
+            string size = header.substr(8);
+            if (size.empty() || size.find_first_not_of("0123456789") != string::npos) throw runtime_error("Bad request size: " + size);
+            if (size.size() > 9 || stoul(size) > MAX_REQUEST_BYTES) {
+                if (size.size() <= 18) cin.ignore(stoll(size)); // skip the source, keeping the stream in step
+                throw runtime_error("Request of " + size + " bytes is over the limit of " + to_string(MAX_REQUEST_BYTES) + " bytes");
+            }
+            size_t n = stoul(size);
+            char buffer[1 << 16];
+            while (c.source.size() < n) {
+                size_t want = min(sizeof buffer, n - c.source.size());
+                cin.read(buffer, static_cast<streamsize>(want));
+                c.source.append(buffer, static_cast<size_t>(cin.gcount()));
+                if (!cin) throw runtime_error("Request ended after " + to_string(c.source.size()) + " of " + size + " bytes");
+            }
+            compile(c, options);
+        } catch (const exception& e) {
+            string message = e.what();
+            cout << "error " << message.size() << '\n' << message << flush;
+            continue;
+        }
+        cout << "ok " << c.outputs.size() << '\n';
+        for (const auto& a : c.outputs) cout << a.first << ' ' << a.second.size() << '\n' << a.second;
+        cout << flush;
+    }
+    return 0;
+}
+
+// One input path per line; blank lines and lines starting with # are skipped.
+static vector<string> read_manifest(const string& path) {
+    ifstream in(path);
+    if (!in) throw runtime_error("Cannot open manifest: " + path);
+    vector<string> inputs;
+    string line;
+    while (getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        inputs.push_back(line);
+    }
+    return inputs;
+}
+
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        cout << "Usage: ./compiler <input_code.txt>" << endl;
+    vector<string> inputs;
+    OptimizerOptions options;
+    string out_dir;
+    string cache_dir;
+    bool batch = false;
+    bool server = false;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--stats") stats = true;
+        else if (arg == "--print") print_listings = true;
+        else if (arg == "--serve") server = true;
+        else if (arg == "--run") run_code = true;
+        else if (arg.compare(0, 12, "--run-limit=") == 0) run_limit = strtoull(arg.c_str() + 12, nullptr, 10);
+        else if (arg.compare(0, 9, "--passes=") == 0) options.passes = split(arg.substr(9), ',');
+        else if (arg.compare(0, 9, "--unroll=") == 0) options.unroll_factor = atoi(arg.c_str() + 9);
+        else if (arg.compare(0, 16, "--unroll-budget=") == 0) options.unroll_budget = atoi(arg.c_str() + 16);
+        else if (arg.compare(0, 15, "--vector-width=") == 0) options.vector_width = atoi(arg.c_str() + 15);
+        else if (arg.compare(0, 7, "--jobs=") == 0) options.jobs = atoi(arg.c_str() + 7);
+        else if (arg.compare(0, 10, "--out-dir=") == 0) out_dir = arg.substr(10);
+        else if (arg == "--background-writes") background_writes = true;
+        else if (arg == "--save-ast") save_ast_image = true;
+        else if (arg == "--save-tac") save_tac_image = true;
+        else if (arg.compare(0, 12, "--cache-dir=") == 0) cache_dir = arg.substr(12);
+        else if (arg == "--from=ast") start = FROM_AST;
+        else if (arg == "--from=tac") start = FROM_TAC;
+        else if (arg.compare(0, 7, "--from=") == 0) {
+            cout << "Unknown start '" << arg.substr(7) << "'. Choose ast or tac." << endl;
+            return 1;
+        }
+        else if (arg.compare(0, 7, "--emit=") == 0) {
+            emit = 0;
+            for (const auto& name : split(arg.substr(7), ',')) {
+                int found = -1;
+                for (int a = 0; a < ARTIFACT_COUNT; ++a) {
+                    if (name == artifacts[a].name) found = a;
+                }
+                if (name == "all") {
+                    emit = (1u << ARTIFACT_COUNT) - 1;
+                } else if (found >= 0) {
+                    emit |= 1u << found;
+                } else if (name != "none") {
+                    cout << "Unknown output '" << name << "'. Choose from tokens, ast, symbols, tac, opt, asm, all or none." << endl;
+                    return 1;
+                }
+            }
+        }
+        else if (arg.compare(0, 11, "--manifest=") == 0) {
+            try {
+                vector<string> listed = read_manifest(arg.substr(11));
+                inputs.insert(inputs.end(), listed.begin(), listed.end());
+            } catch (const exception& e) {
+                cout << e.what() << endl;
+                return 1;
+            }
+            batch = true;
+        }
+        else inputs.push_back(arg);
+    }
+    if (stats) count_allocations();
+    if (run_limit == 0) {
+        cout << "The run limit must be at least 1 instruction." << endl;
+        return 1;
+    }
+    batch = batch || inputs.size() > 1;
+    if (inputs.empty() && !server) {
+        cout << "Usage: ./compiler [--stats] [--print] [--passes=p1,p2,...] [--unroll=N] [--unroll-budget=N] [--vector-width=N]"
+             << " [--jobs=N] [--out-dir=DIR] [--emit=tokens,ast,symbols,tac,opt,asm] [--background-writes]"
+             << " [--save-ast] [--save-tac] [--from=ast|tac] [--cache-dir=DIR] [--run] [--run-limit=N] [--manifest=FILE] <input_code.txt>..." << endl;
+        cout << "       ./compiler --serve [optimizer options]" << endl;
+        return 1;
+    }
+    if (server && start != FROM_SOURCE) {
+        cout << "--serve compiles source text; it cannot be combined with --from." << endl;
+        return 1;
+    }
+    // A saved image starts the pipeline past the stages whose outputs it replaces.
+    if (start == FROM_AST) emit &= ~(1u << TOKENS);
+    if (start == FROM_TAC) emit &= ~((1u << TOKENS) | (1u << AST_TREE) | (1u << SYMBOLS));
+    for (const auto& name : options.passes) {
+        vector<string> known = Optimizer::pass_names();
+        if (find(known.begin(), known.end(), name) == known.end()) {
+            cout << "Unknown pass '" << name << "'. Available passes:" << endl;
+            for (const auto& k : known) cout << "  " << k << endl;
+            return 1;
+        }
+    }
+    if (options.vector_width < 1 || options.vector_width > MAX_VECTOR_WIDTH) {
+        cout << "Vector width must be 1 to " << MAX_VECTOR_WIDTH << "." << endl;
         return 1;
     }
-    string input_file = argv[1];
-
-    // Lexical Analysis
-    Lexer lexer(input_file);
-    vector<Token> tokens = lexer.tokenize();
-    vector<string> token_strs;
-    for (const auto& t : tokens) token_strs.push_back(t.repr());
-    write_to_file("tokens.txt", token_strs);
-
-    // Syntax Analysis
-    Parser parser(tokens);
-    auto parse_tree = parser.parse();
-    write_to_file("parse_tree.txt", parse_tree->repr());
-
-    // Semantic Analysis
-    SemanticAnalyzer semantic_analyzer(parse_tree);
-    SymbolTable symbol_table = semantic_analyzer.analyze();
-    write_to_file("symbol_table.txt", symbol_table.repr());
-
-    // Intermediate Code Generation
-    TACGenerator tac_generator(parse_tree, symbol_table);
-    vector<string> tac = tac_generator.generate();
-    cout << "TAC generated:" << endl;
-    for (const auto& line : tac) cout << line << endl;
-    write_to_file("tac.txt", tac);
-
-    // Code Optimization
-    Optimizer optimizer(tac);
-    vector<string> optimized_code = optimizer.optimize();
-    cout << "Optimized code:" << endl;
-    for (const auto& line : optimized_code) cout << line << endl;
-    cout << "[DIRECT WRITE] Writing to optimized_output.txt:" << endl;
-    for (const auto& line : optimized_code) cout << line << endl;
-    write_to_file("optimized_output.txt", optimized_code);
-    cout << "[DIRECT WRITE] Done writing optimized_output.txt" << endl;
+    if (options.jobs <= 0) options.jobs = max(1u, thread::hardware_concurrency());
+    if (!cache_dir.empty() && start == FROM_SOURCE) {
+        try {
+            cache = make_unique<CompileCache>(cache_dir, options);
+        } catch (const exception& e) {
+            cout << "Cannot use cache directory " << cache_dir << ": " << e.what() << endl;
+            return 1;
+        }
+    }
+    if (server) return serve(options);
+    if (batch) return run_batch(inputs, out_dir.empty() ? "out" : out_dir, options);
 
+    Compilation c;
+    c.input = inputs[0];
+    c.out_dir = out_dir;
+    try {
+        if (!out_dir.empty()) filesystem::create_directories(out_dir);
+        compile(c, options);
+    } catch (const exception& e) {
+        cerr << "[ERROR] " << e.what() << endl;
+        return 1;
+    }
     cout << "Compilation complete. Outputs generated:" << endl;
-    cout << "tokens.txt, parse_tree.txt, symbol_table.txt, tac.txt, optimized_output.txt" << endl;
+    string files;
+    for (int a = 0; a < ARTIFACT_COUNT; ++a) {
+        if (emitted(Artifact(a))) files += string(files.empty() ? "" : ", ") + artifacts[a].file;
+    }
+    if (save_ast_image && start == FROM_SOURCE) files += string(files.empty() ? "" : ", ") + "ast.bin";
+    if (save_tac_image && start != FROM_TAC) files += string(files.empty() ? "" : ", ") + "tac.bin";
+    cout << (files.empty() ? "none" : files) << endl;
+    if (stats) cout << "[STATS] peak RSS: " << peak_rss_kb() << " KB" << endl;
     return 0;
-} 
\ No newline at end of file
+}
@@ -0,0 +1,47 @@
+#!/bin/sh
+# Differential check behind `make check`: every program in tests/ (and
+# input_code.txt) is run as generated TAC, as optimized TAC under several
+# optimizer settings, and as native code assembled from output.s, and all of
+# them have to return the same value.
+compiler=${1:-./compiler}
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+failed=0
+runs=0
+
+for input in input_code.txt tests/*.txt; do
+    for options in "" \
+                   "--passes=sparse_conditional_constant_propagation" \
+                   "--passes=loop_vectorization,loop_unrolling,full_dead_code_elimination" \
+                   "--unroll=1" \
+                   "--unroll=8 --unroll-budget=512" \
+                   "--vector-width=1" \
+                   "--vector-width=3" \
+                   "--vector-width=16"; do
+        runs=$((runs + 1))
+        label="$input${options:+ $options}"
+        # $options is split into words on purpose.
+        output=$("$compiler" --run --emit=asm --out-dir="$work" $options "$input" 2>&1)
+        if echo "$output" | grep -q -e '^\[ERROR\]' -e 'does not return the same value' -e 'did not finish'; then
+            echo "FAIL $label"
+            echo "$output" | grep -e '^\[ERROR\]' -e '^\[RUN\]'
+            failed=$((failed + 1))
+            continue
+        fi
+        expected=$(echo "$output" | sed -n 's/^\[RUN\] main: optimized returned \(-*[0-9]*\) .*/\1/p')
+        if ! cc "$work/output.s" -o "$work/program" 2> "$work/cc.txt"; then
+            echo "FAIL $label: output.s does not assemble"
+            head -5 "$work/cc.txt"
+            failed=$((failed + 1))
+            continue
+        fi
+        got=$("$work/program")
+        if [ -z "$expected" ] || [ "$got" != "$expected" ]; then
+            echo "FAIL $label: native code printed '$got', --run returned '$expected'"
+            failed=$((failed + 1))
+        fi
+    done
+done
+
+echo "$runs runs, $failed failed"
+[ "$failed" -eq 0 ]
@@ -3,40 +3,42 @@
 #include <iostream>
 using namespace std;
 
-void write_to_file(const string& filename, const vector<string>& content) {
-    ofstream f(filename);
-    if (!f) {
-        cerr << "[ERROR] Cannot open file: " << filename << endl;
-        return;
-    }
-    for (const auto& line : content) {
-        f << line << '\n';
-    }
-    f.flush();
-    f.close();
-    ifstream check(filename);
-    string result((istreambuf_iterator<char>(check)), istreambuf_iterator<char>());
-    if (result.empty()) {
-        cerr << "[WARNING] " << filename << " is empty after writing!" << endl;
-    } else {
-        cout << "[INFO] " << filename << " successfully written." << endl;
+string join_lines(const vector<string>& lines) {
+    size_t size = 0;
+    for (const auto& line : lines) size += line.size() + 1;
+    string text;
+    text.reserve(size);
+    for (const auto& line : lines) {
+        text += line;
+        text += '\n';
     }
+    return text;
 }
 
-void write_to_file(const string& filename, const string& content) {
+bool write_to_file(const string& filename, const vector<string>& content, bool report) {
+    return write_to_file(filename, join_lines(content), report);
+}
+
+// The whole file goes out in one write; nothing is read back.
+bool write_to_file(const string& filename, const string& content, bool report) {
     ofstream f(filename);
+    if (f) f.write(content.data(), static_cast<streamsize>(content.size()));
+    if (f) f.close();
     if (!f) {
-        cerr << "[ERROR] Cannot open file: " << filename << endl;
-        return;
+        if (report) cerr << "[ERROR] Cannot write file: " << filename << endl;
+        return false;
     }
-    f << content;
-    f.flush();
-    f.close();
-    ifstream check(filename);
-    string result((istreambuf_iterator<char>(check)), istreambuf_iterator<char>());
-    if (result.empty()) {
-        cerr << "[WARNING] " << filename << " is empty after writing!" << endl;
-    } else {
-        cout << "[INFO] " << filename << " successfully written." << endl;
+    return true;
+}
+
+vector<string> split(const string& text, char sep) {
+    vector<string> parts;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = text.find(sep, start);
+        if (end == string::npos) end = text.size();
+        if (end > start) parts.push_back(text.substr(start, end - start));
+        start = end + 1;
     }
-} 
\ No newline at end of file
+    return parts;
+}
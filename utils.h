@@ -3,7 +3,12 @@
 #include <string>
 #include <vector>
 
-void write_to_file(const std::string& filename, const std::vector<std::string>& content);
-void write_to_file(const std::string& filename, const std::string& content);
+// Returns false if the file could not be written, and with report set also
+// says so on stderr. Lines are written with a newline after each.
+bool write_to_file(const std::string& filename, const std::vector<std::string>& content, bool report = true);
+bool write_to_file(const std::string& filename, const std::string& content, bool report = true);
+// The lines with a newline after each, as write_to_file writes them.
+std::string join_lines(const std::vector<std::string>& lines);
+std::vector<std::string> split(const std::string& text, char sep);
 
 #endif // UTILS_H 
\ No newline at end of file